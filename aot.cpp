@@ -0,0 +1,458 @@
+#include "aot.hpp"
+#include "expression.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Unsupported {
+    std::string reason;
+};
+
+struct Binding {
+    std::string name;
+    std::string identifier;
+};
+
+using Scope = std::vector<Binding>;
+
+std::string quote(const std::string& text)
+{
+    std::string result = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            // Escape octal: no se mezcla con los caracteres siguientes
+            char escaped[8];
+            snprintf(escaped, sizeof escaped, "\\%03o", c);
+            result += escaped;
+        } else {
+            result += static_cast<char>(c);
+        }
+    }
+    return result + "\"";
+}
+
+std::string describe(const Expression& node)
+{
+    std::string text = node.to_string();
+    if (text.size() > 40) {
+        text = text.substr(0, 37) + "...";
+    }
+    return text;
+}
+
+// Traduce la expresión final y las funciones globales que alcanza a C++ sobre
+// aot::Value. Cada función se emite una sola vez y se declara antes de usarla.
+class Emitter
+{
+public:
+    explicit Emitter(const Environment& _globals) : globals{_globals} {}
+
+    std::string translate(const Expression& program);
+
+private:
+    std::string visit(const Expression& node, Scope& scope);
+    std::string visit_binary(const BinaryExpression& node, Scope& scope);
+    std::string visit_unary(const UnaryExpression& node, Scope& scope);
+    std::string condition(const Expression& node, Scope& scope);
+    const std::string& function(const std::string& name);
+    std::string constant(const std::string& definition);
+
+    std::string fresh(const char* prefix) { return prefix + std::to_string(counter++); }
+
+    struct Pending {
+        std::string name;
+        std::string symbol;
+        std::shared_ptr<Closure> closure;
+    };
+
+    static std::string signature(const Pending& function);
+
+    const Environment& globals;
+    std::map<std::string, std::string> symbols;
+    std::map<std::string, std::size_t> symbols_arity;
+    std::vector<Pending> pending;
+    std::vector<std::string> constants;
+    int counter = 0;
+};
+
+std::string Emitter::translate(const Expression& program)
+{
+    Scope scope;
+    std::string body = visit(program, scope);
+
+    std::ostringstream definitions;
+    // Traducir una función puede agregar otras a pending
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        auto function = pending[i];
+        Scope parameters;
+        for (const auto& name : function.closure->get_parameter_names()) {
+            parameters.push_back({name, "p" + std::to_string(parameters.size())});
+        }
+        std::string function_body = visit(*function.closure->get_body_expression(), parameters);
+        definitions << "// " << function.name << "\n"
+                    << "static aot::Value " << function.symbol << "(" << signature(function) << ")\n{\n"
+                    << "    return " << function_body << ";\n}\n\n";
+    }
+
+    std::ostringstream out;
+    out << "// Generado por --emit-exe\n"
+        << "#include \"aot_runtime.hpp\"\n\n";
+    for (const auto& definition : constants) {
+        out << definition << "\n";
+    }
+    if (!constants.empty()) out << "\n";
+    for (const auto& function : pending) {
+        out << "static aot::Value " << function.symbol << "(" << signature(function) << ");  // " << function.name << "\n";
+    }
+    if (!pending.empty()) out << "\n";
+    out << definitions.str()
+        << "static aot::Value program()\n{\n    return " << body << ";\n}\n\n"
+        << "int main()\n{\n    return aot::run(program);\n}\n";
+    return out.str();
+}
+
+const std::string& Emitter::function(const std::string& name)
+{
+    auto found = symbols.find(name);
+    if (found != symbols.end()) {
+        return found->second;
+    }
+    auto closure = std::dynamic_pointer_cast<Closure>(globals.lookup(name));
+    if (!closure) {
+        throw Unsupported{"function " + name + " does not exist"};
+    }
+    std::string symbol = "f" + std::to_string(pending.size());
+    pending.push_back({name, symbol, closure});
+    symbols_arity[symbol] = closure->get_parameter_names().size();
+    return symbols.emplace(name, symbol).first->second;
+}
+
+// Los parámetros se llaman p0, p1, ...
+std::string Emitter::signature(const Pending& function)
+{
+    std::string text;
+    for (std::size_t i = 0; i < function.closure->get_parameter_names().size(); ++i) {
+        if (i > 0) text += ", ";
+        text += "const aot::Value& p" + std::to_string(i);
+    }
+    return text;
+}
+
+// Los literales de string se crean una sola vez al iniciar el programa
+std::string Emitter::constant(const std::string& definition)
+{
+    std::string identifier = "c" + std::to_string(constants.size());
+    constants.push_back("static const aot::Value " + identifier + " = " + definition + ";");
+    return identifier;
+}
+
+// Condición de if como bool de C++; las comparaciones no crean un Value
+std::string Emitter::condition(const Expression& node, Scope& scope)
+{
+    auto binary = dynamic_cast<const BinaryExpression*>(&node);
+    auto call = [&](const char* function) {
+        return std::string{function} + "(" + visit(*binary->get_left_expression(), scope) + ", "
+            + visit(*binary->get_right_expression(), scope) + ")";
+    };
+    if (dynamic_cast<const LessExpression*>(&node)) return call("aot::less");
+    if (dynamic_cast<const LessEqExpression*>(&node)) return call("aot::less_eq");
+    if (dynamic_cast<const GreaterExpression*>(&node)) return call("aot::greater");
+    if (dynamic_cast<const GreaterEqExpression*>(&node)) return call("aot::greater_eq");
+    if (dynamic_cast<const EqualExpression*>(&node)) return call("aot::equal");
+    if (dynamic_cast<const NotEqualExpression*>(&node)) return "!" + call("aot::equal");
+    return "aot::truthy(" + visit(node, scope) + ")";
+}
+
+std::string Emitter::visit(const Expression& node, Scope& scope)
+{
+    if (auto n = dynamic_cast<const IntExpression*>(&node)) {
+        return "aot::Value::integer(" + std::to_string(n->get_value()) + ")";
+    }
+    if (auto n = dynamic_cast<const RealExpression*>(&node)) {
+        if (!std::isfinite(n->get_value())) {
+            throw Unsupported{"non-finite real literal"};
+        }
+        char text[64];
+        snprintf(text, sizeof text, "%.17g", n->get_value());
+        std::string literal = text;
+        if (literal.find_first_of(".e") == std::string::npos) {
+            literal += ".0";
+        }
+        return "aot::Value::real(" + literal + ")";
+    }
+    if (auto n = dynamic_cast<const BoolExpression*>(&node)) {
+        return n->get_value() ? "aot::Value::boolean(true)" : "aot::Value::boolean(false)";
+    }
+    if (auto n = dynamic_cast<const StrExpression*>(&node)) {
+        return constant("aot::Value::str(" + quote(n->get_value()) + ")");
+    }
+    if (auto n = dynamic_cast<const NameExpression*>(&node)) {
+        for (auto it = scope.rbegin(); it != scope.rend(); ++it) {
+            if (it->name == n->get_name()) return it->identifier;
+        }
+        throw Unsupported{"free variable " + n->get_name()};
+    }
+    if (auto n = dynamic_cast<const LetExpression*>(&node)) {
+        if (n->is_recursive()) {
+            throw Unsupported{"local functions (letrec)"};
+        }
+        // Todas las variables en una sola lambda, en orden
+        std::size_t depth = scope.size();
+        std::string declarations;
+        std::string body;
+        try {
+            for (const auto& [var_name, var_expression] : n->get_bindings()) {
+                auto name = std::dynamic_pointer_cast<NameExpression>(var_name);
+                if (!name) {
+                    throw Unsupported{"let without a variable name"};
+                }
+                std::string value = visit(*var_expression, scope);
+                std::string identifier = fresh("v");
+                scope.push_back({name->get_name(), identifier});
+                declarations += "const aot::Value " + identifier + " = " + value + "; ";
+            }
+            body = visit(*n->get_body_expression(), scope);
+        } catch (...) {
+            scope.resize(depth);
+            throw;
+        }
+        scope.resize(depth);
+        return "[&]() { " + declarations + "return " + body + "; }()";
+    }
+    if (auto n = dynamic_cast<const IfElseExpression*>(&node)) {
+        return "(" + condition(*n->get_condition_expression(), scope) + " ? "
+            + visit(*n->get_true_expression(), scope) + " : "
+            + visit(*n->get_false_expression(), scope) + ")";
+    }
+    if (auto n = dynamic_cast<const CallExpression*>(&node)) {
+        auto name = std::dynamic_pointer_cast<NameExpression>(n->get_left_expression());
+        for (const auto& binding : scope) {
+            if (binding.name == name->get_name()) {
+                throw Unsupported{"call through local " + binding.name};
+            }
+        }
+        const auto& arguments = n->get_arguments();
+        const std::string& symbol = function(name->get_name());
+        if (symbols_arity[symbol] != arguments.size()) {
+            throw Unsupported{"wrong number of arguments for " + name->get_name()};
+        }
+        if (arguments.size() == 1) {
+            return symbol + "(" + visit(*arguments.front(), scope) + ")";
+        }
+        // El orden de evaluación de los argumentos de C++ no está definido:
+        // se fijan de izquierda a derecha como en el intérprete
+        std::string code = "[&]() { ";
+        std::string call = symbol + "(";
+        for (std::size_t i = 0; i < arguments.size(); ++i) {
+            std::string identifier = fresh("a");
+            code += "const aot::Value " + identifier + " = " + visit(*arguments[i], scope) + "; ";
+            call += (i > 0 ? ", " : "") + identifier;
+        }
+        return code + "return " + call + "); }()";
+    }
+    if (auto n = dynamic_cast<const ArrayExpression*>(&node)) {
+        std::string elements;
+        for (const auto& element : n->get_elements()) {
+            if (!elements.empty()) elements += ", ";
+            elements += visit(*element, scope);
+        }
+        return "aot::Value::array({" + elements + "})";
+    }
+    if (auto n = dynamic_cast<const TupleExpression*>(&node)) {
+        std::string fields;
+        for (const auto& field : n->get_elements()) {
+            if (!fields.empty()) fields += ", ";
+            fields += visit(*field, scope);
+        }
+        return "aot::Value::tuple({" + fields + "})";
+    }
+    if (auto n = dynamic_cast<const SliceExpression*>(&node)) {
+        std::string array = fresh("a");
+        std::string begin = fresh("a");
+        std::string end = fresh("a");
+        return "[&]() { const aot::Value " + array + " = " + visit(*n->get_array_expression(), scope)
+            + "; const aot::Value " + begin + " = " + visit(*n->get_begin_expression(), scope)
+            + "; const aot::Value " + end + " = " + visit(*n->get_end_expression(), scope)
+            + "; return aot::array_slice(" + array + ", " + begin + ", " + end + "); }()";
+    }
+    if (auto n = dynamic_cast<const BinaryExpression*>(&node)) {
+        return visit_binary(*n, scope);
+    }
+    if (auto n = dynamic_cast<const UnaryExpression*>(&node)) {
+        return visit_unary(*n, scope);
+    }
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+std::string Emitter::visit_binary(const BinaryExpression& node, Scope& scope)
+{
+    if (dynamic_cast<const AssignmentExpression*>(&node)) {
+        throw Unsupported{"assignment " + describe(node)};
+    }
+    std::string left = visit(*node.get_left_expression(), scope);
+    std::string right = visit(*node.get_right_expression(), scope);
+    auto call = [&](const char* function) {
+        return std::string{function} + "(" + left + ", " + right + ")";
+    };
+    auto boolean = [&](const std::string& value) {
+        return "aot::Value::boolean(" + value + ")";
+    };
+    // and/or se evalúan completos en el intérprete: sin cortocircuito
+    auto logical = [&](const char* op, const char* message) {
+        return boolean("aot::to_bool(" + left + ", \"" + message + "\") " + op
+                       + " aot::to_bool(" + right + ", \"" + message + "\")");
+    };
+
+    if (dynamic_cast<const AddExpression*>(&node)) return call("aot::add");
+    if (dynamic_cast<const SubExpression*>(&node)) return call("aot::sub");
+    if (dynamic_cast<const MulExpression*>(&node)) return call("aot::mul");
+    if (dynamic_cast<const DivExpression*>(&node)) return call("aot::div");
+    if (dynamic_cast<const ModExpression*>(&node)) return call("aot::mod");
+    if (dynamic_cast<const LessExpression*>(&node)) return boolean(call("aot::less"));
+    if (dynamic_cast<const LessEqExpression*>(&node)) return boolean(call("aot::less_eq"));
+    if (dynamic_cast<const GreaterExpression*>(&node)) return boolean(call("aot::greater"));
+    if (dynamic_cast<const GreaterEqExpression*>(&node)) return boolean(call("aot::greater_eq"));
+    if (dynamic_cast<const EqualExpression*>(&node)) return boolean(call("aot::equal"));
+    if (dynamic_cast<const NotEqualExpression*>(&node)) return boolean("!" + call("aot::equal"));
+    if (dynamic_cast<const AndExpression*>(&node)) return logical("&", "Type error: and requires booleans");
+    if (dynamic_cast<const OrExpression*>(&node)) return logical("|", "Type error: or requires booleans");
+    if (dynamic_cast<const XorExpression*>(&node)) return logical("!=", "Type error: xor requires booleans");
+    if (dynamic_cast<const ConcatExpression*>(&node)) return call("aot::concat");
+    if (dynamic_cast<const PairExpression*>(&node)) return call("aot::Value::pair");
+    if (dynamic_cast<const ArrayAddExpression*>(&node)) return call("aot::array_add");
+    if (dynamic_cast<const ArrayDelExpression*>(&node)) return call("aot::array_del");
+    if (dynamic_cast<const IndexExpression*>(&node)) return call("aot::array_index");
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+std::string Emitter::visit_unary(const UnaryExpression& node, Scope& scope)
+{
+    std::string operand = visit(*node.get_expression(), scope);
+    auto call = [&](const char* function) {
+        return std::string{function} + "(" + operand + ")";
+    };
+
+    if (dynamic_cast<const PrintExpression*>(&node)) return operand;
+    if (dynamic_cast<const NotExpression*>(&node)) {
+        return "aot::Value::boolean(!aot::to_bool(" + operand + ", \"Type error: not requires a boolean\"))";
+    }
+    if (dynamic_cast<const NegExpression*>(&node)) return call("aot::neg");
+    if (dynamic_cast<const FstExpression*>(&node)) return call("aot::fst");
+    if (dynamic_cast<const SndExpression*>(&node)) return call("aot::snd");
+    if (auto field = dynamic_cast<const TupleFieldExpression*>(&node)) {
+        return "aot::tuple_field(" + operand + ", " + std::to_string(field->get_index()) + ")";
+    }
+    if (dynamic_cast<const HeadExpression*>(&node)) return call("aot::head");
+    if (dynamic_cast<const TailExpression*>(&node)) return call("aot::tail");
+    if (dynamic_cast<const LengthExpression*>(&node)) return call("aot::length");
+    if (dynamic_cast<const RtoSExpression*>(&node)) return call("aot::rtos");
+    if (dynamic_cast<const ItoSExpression*>(&node)) return call("aot::itos");
+    if (dynamic_cast<const ItoRExpression*>(&node)) return call("aot::itor");
+    if (dynamic_cast<const RtoIExpression*>(&node)) return call("aot::rtoi");
+    if (dynamic_cast<const UnitExpression*>(&node)) return call("aot::unit");
+    if (dynamic_cast<const IsUniTExpression*>(&node)) return call("aot::is_unit");
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+bool file_exists(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+std::string runtime_directory()
+{
+    const char* configured = getenv("AOT_RUNTIME_DIR");
+    if (configured != nullptr) {
+        return configured;
+    }
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof path - 1);
+    if (length <= 0) {
+        return ".";
+    }
+    std::string executable{path, static_cast<std::size_t>(length)};
+    auto slash = executable.rfind('/');
+    return slash == std::string::npos ? "." : executable.substr(0, slash);
+}
+
+// Argumento entre comillas simples para la shell; cada ' se cierra y se escapa
+std::string shell_quote(const std::string& text)
+{
+    std::string result = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            result += "'\\''";
+        } else {
+            result += c;
+        }
+    }
+    return result + "'";
+}
+
+std::string first_line(const std::string& path)
+{
+    std::ifstream in{path};
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+} // namespace
+
+bool emit_executable(const Expression& program, const Environment& globals,
+                     const std::string& output_path, std::string& error)
+{
+    std::string source;
+    try {
+        Emitter emitter{globals};
+        source = emitter.translate(program);
+    } catch (const Unsupported& e) {
+        error = e.reason;
+        return false;
+    }
+
+    std::string runtime = runtime_directory();
+    std::string library = runtime + "/libaot_runtime.a";
+    if (!file_exists(runtime + "/aot_runtime.hpp") || !file_exists(library)) {
+        error = "runtime not found in " + runtime + " (set AOT_RUNTIME_DIR)";
+        return false;
+    }
+
+    std::string source_path = output_path + ".cpp";
+    std::string log_path = output_path + ".log";
+    {
+        std::ofstream out{source_path};
+        if (!out) {
+            error = "could not write " + source_path;
+            return false;
+        }
+        out << source;
+    }
+    // AOT_CXX permite elegir el compilador; por defecto el del sistema
+    const char* compiler = getenv("AOT_CXX");
+    std::string command = std::string{compiler != nullptr ? compiler : "c++"}
+        + " -std=c++17 -O2 -fwrapv -I" + shell_quote(runtime) + " -o " + shell_quote(output_path) + " "
+        + shell_quote(source_path) + " " + shell_quote(library) + " 2> " + shell_quote(log_path);
+    bool compiled = std::system(command.c_str()) == 0;
+    if (!compiled) {
+        error = "compiler failed: " + first_line(log_path) + " (source kept in " + source_path + ")";
+        unlink(log_path.c_str());
+        return false;
+    }
+    unlink(source_path.c_str());
+    unlink(log_path.c_str());
+    return true;
+}
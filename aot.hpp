@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include "utils.hpp"
+
+// Compilación anticipada (--emit-exe salida): la expresión final y las
+// funciones globales que alcanza se traducen a una unidad de C++ que se
+// enlaza con el runtime de aot_runtime.hpp (libaot_runtime.a) y se compila
+// a un ejecutable que no necesita el intérprete ni el código fuente. El
+// runtime se busca en AOT_RUNTIME_DIR o junto al ejecutable de main.
+// Retorna false y deja el motivo en error si el programa usa algo que no se
+// puede traducir (fun anidadas, asignaciones) o si el compilador falla.
+bool emit_executable(const Expression& program, const Environment& globals,
+                     const std::string& output_path, std::string& error);
@@ -0,0 +1,313 @@
+#include "aot_runtime.hpp"
+
+#include <cstdio>
+
+namespace aot {
+
+Value Value::str(std::string value)
+{
+    Value v;
+    v.kind = Kind::Str;
+    v.text = std::make_shared<const std::string>(std::move(value));
+    return v;
+}
+
+Value Value::pair(Value left, Value right)
+{
+    Value v;
+    v.kind = Kind::Pair;
+    v.items = std::make_shared<const std::vector<Value>>(std::vector<Value>{std::move(left), std::move(right)});
+    return v;
+}
+
+Value Value::tuple(std::vector<Value> fields)
+{
+    Value v;
+    v.kind = Kind::Tuple;
+    v.items = std::make_shared<const std::vector<Value>>(std::move(fields));
+    return v;
+}
+
+Value Value::array(std::vector<Value> elements)
+{
+    Value v;
+    v.kind = Kind::Array;
+    v.items = std::make_shared<const std::vector<Value>>(std::move(elements));
+    return v;
+}
+
+void type_error(const char* message)
+{
+    throw std::runtime_error(message);
+}
+
+Value div(const Value& a, const Value& b)
+{
+    if (a.is(Value::Kind::Int) && b.is(Value::Kind::Int)) {
+        if (b.get_int() == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        return Value::integer(a.get_int() / b.get_int());
+    }
+    if (a.is(Value::Kind::Real) && b.is(Value::Kind::Real)) return Value::real(a.get_real() / b.get_real());
+    type_error("Type error: Cannot divide incompatible types");
+}
+
+Value mod(const Value& a, const Value& b)
+{
+    if (!a.is(Value::Kind::Int) || !b.is(Value::Kind::Int)) {
+        type_error("Type error: Modulo requires integers");
+    }
+    if (b.get_int() == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    return Value::integer(a.get_int() % b.get_int());
+}
+
+Value neg(const Value& a)
+{
+    if (a.is(Value::Kind::Int)) return Value::integer(-a.get_int());
+    // Como en NegExpression::eval, el negativo de un real se trunca a entero
+    if (a.is(Value::Kind::Real)) return Value::integer(static_cast<int>(-a.get_real()));
+    type_error("Type error: Cannot negate a non-numeric value");
+}
+
+namespace {
+
+template <typename Op>
+bool compare(const Value& a, const Value& b, Op op)
+{
+    if (a.is(Value::Kind::Int) && b.is(Value::Kind::Int)) return op(a.get_int(), b.get_int());
+    if (a.is(Value::Kind::Real) && b.is(Value::Kind::Real)) return op(a.get_real(), b.get_real());
+    type_error("Type error: Cannot compare incompatible types");
+}
+
+const std::vector<Value>& expect_array(const Value& a, const char* message)
+{
+    if (!a.is(Value::Kind::Array)) {
+        type_error(message);
+    }
+    return a.get_items();
+}
+
+} // namespace
+
+bool less(const Value& a, const Value& b) { return compare(a, b, [](auto x, auto y) { return x < y; }); }
+bool less_eq(const Value& a, const Value& b) { return compare(a, b, [](auto x, auto y) { return x <= y; }); }
+bool greater(const Value& a, const Value& b) { return compare(a, b, [](auto x, auto y) { return x > y; }); }
+bool greater_eq(const Value& a, const Value& b) { return compare(a, b, [](auto x, auto y) { return x >= y; }); }
+
+// Igual que EqualExpression::eval: comparación estructural, los tipos
+// distintos nunca son iguales
+bool equal(const Value& a, const Value& b)
+{
+    if (a.get_kind() != b.get_kind()) return false;
+    switch (a.get_kind()) {
+        case Value::Kind::Int: return a.get_int() == b.get_int();
+        case Value::Kind::Real: return a.get_real() == b.get_real();
+        case Value::Kind::Bool: return a.get_bool() == b.get_bool();
+        case Value::Kind::Str: return a.get_str() == b.get_str();
+        case Value::Kind::Pair:
+        case Value::Kind::Tuple:
+        case Value::Kind::Array: {
+            const auto& left = a.get_items();
+            const auto& right = b.get_items();
+            // Sin atajo por identidad: un NaN dentro no es igual a sí mismo
+            if (left.size() != right.size()) return false;
+            for (std::size_t i = 0; i < left.size(); ++i) {
+                if (!equal(left[i], right[i])) return false;
+            }
+            return true;
+        }
+        default: return false;
+    }
+}
+
+bool to_bool(const Value& a, const char* message)
+{
+    if (!a.is(Value::Kind::Bool)) {
+        type_error(message);
+    }
+    return a.get_bool();
+}
+
+Value concat(const Value& a, const Value& b)
+{
+    if (!a.is(Value::Kind::Str) || !b.is(Value::Kind::Str)) {
+        type_error("Type error: # requires strings");
+    }
+    return Value::str(a.get_str() + b.get_str());
+}
+
+Value fst(const Value& a)
+{
+    if (!a.is(Value::Kind::Pair)) type_error("FstExpression: Operand must be a pair");
+    return a.get_items()[0];
+}
+
+Value snd(const Value& a)
+{
+    if (!a.is(Value::Kind::Pair)) type_error("SndExpression: Operand must be a pair");
+    return a.get_items()[1];
+}
+
+Value tuple_field(const Value& a, std::size_t index)
+{
+    if (!a.is(Value::Kind::Tuple)) type_error("TupleFieldExpression: Operand must be a tuple");
+    if (index >= a.get_items().size()) {
+        throw std::runtime_error("TupleFieldExpression: Field out of range");
+    }
+    return a.get_items()[index];
+}
+
+Value head(const Value& a)
+{
+    const auto& elements = expect_array(a, "HeadExpression: Operand must be an array or pair");
+    if (elements.empty()) {
+        throw std::runtime_error("HeadExpression: Cannot get head of empty array");
+    }
+    return elements[0];
+}
+
+Value tail(const Value& a)
+{
+    const auto& elements = expect_array(a, "TailExpression: Operand must be an array or pair");
+    if (elements.empty()) {
+        throw std::runtime_error("TailExpression: Cannot get tail of empty array");
+    }
+    return Value::array(std::vector<Value>(elements.begin() + 1, elements.end()));
+}
+
+Value length(const Value& a)
+{
+    const auto& elements = expect_array(a, "LengthExpression: Operand must be an array");
+    return Value::integer(static_cast<int>(elements.size()));
+}
+
+Value array_add(const Value& array, const Value& element)
+{
+    auto elements = expect_array(array, "ArrayAddExpression: First operand must be an array");
+    elements.push_back(element);
+    return Value::array(std::move(elements));
+}
+
+Value array_del(const Value& array, const Value& index)
+{
+    const auto& elements = expect_array(array, "ArrayDelExpression: First operand must be an array");
+    if (!index.is(Value::Kind::Int)) {
+        type_error("ArrayDelExpression: Index must be an integer");
+    }
+    int position = index.get_int();
+    if (position < 0 || position >= static_cast<int>(elements.size())) {
+        throw std::runtime_error("ArrayDelExpression: Index out of bounds");
+    }
+    std::vector<Value> remaining;
+    remaining.reserve(elements.size() - 1);
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        if (static_cast<int>(i) != position) remaining.push_back(elements[i]);
+    }
+    return Value::array(std::move(remaining));
+}
+
+Value array_index(const Value& array, const Value& index)
+{
+    const auto& elements = expect_array(array, "IndexExpression: First operand must be an array");
+    if (!index.is(Value::Kind::Int)) {
+        type_error("IndexExpression: Index must be an integer");
+    }
+    int position = index.get_int();
+    if (position < 0 || position >= static_cast<int>(elements.size())) {
+        throw std::runtime_error("IndexExpression: Index out of bounds");
+    }
+    return elements[position];
+}
+
+Value array_slice(const Value& array, const Value& begin, const Value& end)
+{
+    const auto& elements = expect_array(array, "SliceExpression: First operand must be an array");
+    if (!begin.is(Value::Kind::Int) || !end.is(Value::Kind::Int)) {
+        type_error("SliceExpression: Bounds must be integers");
+    }
+    int first = begin.get_int();
+    int last = end.get_int();
+    if (first < 0 || last < first || last > static_cast<int>(elements.size())) {
+        throw std::runtime_error("SliceExpression: Slice out of bounds");
+    }
+    return Value::array(std::vector<Value>(elements.begin() + first, elements.begin() + last));
+}
+
+Value rtos(const Value& a)
+{
+    if (!a.is(Value::Kind::Real)) type_error("Type error: rtos requires a real");
+    return Value::str(std::to_string(a.get_real()));
+}
+
+Value itos(const Value& a)
+{
+    if (!a.is(Value::Kind::Int)) type_error("Type error: itos requires an int");
+    return Value::str(std::to_string(a.get_int()));
+}
+
+Value itor(const Value& a)
+{
+    if (!a.is(Value::Kind::Int)) type_error("Type error: itor requires an int");
+    return Value::real(static_cast<double>(a.get_int()));
+}
+
+Value rtoi(const Value& a)
+{
+    if (!a.is(Value::Kind::Real)) type_error("Type error: rtoi requires a real");
+    return Value::integer(static_cast<int>(a.get_real()));
+}
+
+// Como en UnitExpression::eval: ningún valor calculado es un UnitExpression
+Value unit(const Value&)
+{
+    return Value::integer(0);
+}
+
+Value is_unit(const Value& a)
+{
+    return Value::integer(a.is(Value::Kind::Int) && a.get_int() == 0 ? 1 : 0);
+}
+
+std::string to_string(const Value& a)
+{
+    switch (a.get_kind()) {
+        case Value::Kind::Int: return "(" + std::to_string(a.get_int()) + ")";
+        case Value::Kind::Real: return "(" + std::to_string(a.get_real()) + ")";
+        case Value::Kind::Bool: return "(" + std::to_string(a.get_bool()) + ")";
+        case Value::Kind::Str: return "\"(" + a.get_str() + ")\"";
+        case Value::Kind::Pair: return "(pair" + to_string(a.get_items()[0]) + to_string(a.get_items()[1]) + ")";
+        case Value::Kind::Tuple: {
+            std::string result = "(tuple";
+            for (const auto& field : a.get_items()) {
+                result += to_string(field);
+            }
+            return result + ")";
+        }
+        case Value::Kind::Array: {
+            std::string result = "[";
+            const auto& elements = a.get_items();
+            for (std::size_t i = 0; i < elements.size(); ++i) {
+                if (i > 0) result += ", ";
+                result += to_string(elements[i]);
+            }
+            return result + "]";
+        }
+    }
+    return "";
+}
+
+int run(Value (*program)())
+{
+    try {
+        Value value = program();
+        printf("Result: %s\n", to_string(value).c_str());
+    } catch (const std::exception& e) {
+        printf("Evaluation error: %s\n", e.what());
+    }
+    return 0;
+}
+
+} // namespace aot
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Runtime de los ejecutables generados con --emit-exe. No depende del
+// intérprete: los valores son escalares sin asignación de memoria o
+// referencias compartidas a strings, pares y arreglos. Las operaciones
+// replican la semántica de los eval de expression.cpp, incluidos los
+// mensajes de error y el formato de to_string.
+namespace aot {
+
+class Value
+{
+public:
+    enum class Kind : unsigned char { Int, Real, Bool, Str, Pair, Tuple, Array };
+
+    Value() noexcept : kind{Kind::Int}, i{0} {}
+
+    static Value integer(int value) noexcept { Value v; v.kind = Kind::Int; v.i = value; return v; }
+    static Value real(double value) noexcept { Value v; v.kind = Kind::Real; v.r = value; return v; }
+    static Value boolean(bool value) noexcept { Value v; v.kind = Kind::Bool; v.b = value; return v; }
+    static Value str(std::string value);
+    static Value pair(Value left, Value right);
+    static Value tuple(std::vector<Value> fields);
+    static Value array(std::vector<Value> elements);
+
+    Kind get_kind() const noexcept { return kind; }
+    bool is(Kind expected) const noexcept { return kind == expected; }
+
+    int get_int() const noexcept { return i; }
+    double get_real() const noexcept { return r; }
+    bool get_bool() const noexcept { return b; }
+    const std::string& get_str() const noexcept { return *text; }
+    // Los pares y las tuplas se guardan como arreglos
+    const std::vector<Value>& get_items() const noexcept { return *items; }
+
+private:
+    Kind kind;
+    union {
+        int i;
+        double r;
+        bool b;
+    };
+    std::shared_ptr<const std::string> text;
+    std::shared_ptr<const std::vector<Value>> items;
+};
+
+[[noreturn]] void type_error(const char* message);
+
+inline Value add(const Value& a, const Value& b)
+{
+    if (a.is(Value::Kind::Int) && b.is(Value::Kind::Int)) return Value::integer(a.get_int() + b.get_int());
+    if (a.is(Value::Kind::Real) && b.is(Value::Kind::Real)) return Value::real(a.get_real() + b.get_real());
+    type_error("Type error: Cannot add incompatible types");
+}
+
+inline Value sub(const Value& a, const Value& b)
+{
+    if (a.is(Value::Kind::Int) && b.is(Value::Kind::Int)) return Value::integer(a.get_int() - b.get_int());
+    if (a.is(Value::Kind::Real) && b.is(Value::Kind::Real)) return Value::real(a.get_real() - b.get_real());
+    type_error("Type error: Cannot subtract incompatible types");
+}
+
+inline Value mul(const Value& a, const Value& b)
+{
+    if (a.is(Value::Kind::Int) && b.is(Value::Kind::Int)) return Value::integer(a.get_int() * b.get_int());
+    if (a.is(Value::Kind::Real) && b.is(Value::Kind::Real)) return Value::real(a.get_real() * b.get_real());
+    type_error("Type error: Cannot multiply incompatible types");
+}
+
+Value div(const Value& a, const Value& b);
+Value mod(const Value& a, const Value& b);
+Value neg(const Value& a);
+
+// Comparaciones: el código generado las usa como bool de C++
+bool less(const Value& a, const Value& b);
+bool less_eq(const Value& a, const Value& b);
+bool greater(const Value& a, const Value& b);
+bool greater_eq(const Value& a, const Value& b);
+bool equal(const Value& a, const Value& b);
+
+bool to_bool(const Value& a, const char* message);
+
+// Condición de if: como en IfElseExpression::eval, solo true toma la rama
+inline bool truthy(const Value& a) noexcept
+{
+    return a.is(Value::Kind::Bool) && a.get_bool();
+}
+
+Value concat(const Value& a, const Value& b);
+Value fst(const Value& a);
+Value snd(const Value& a);
+Value tuple_field(const Value& a, std::size_t index);
+Value head(const Value& a);
+Value tail(const Value& a);
+Value length(const Value& a);
+Value array_add(const Value& array, const Value& element);
+Value array_del(const Value& array, const Value& index);
+Value array_index(const Value& array, const Value& index);
+Value array_slice(const Value& array, const Value& begin, const Value& end);
+Value rtos(const Value& a);
+Value itos(const Value& a);
+Value itor(const Value& a);
+Value rtoi(const Value& a);
+Value unit(const Value& a);
+Value is_unit(const Value& a);
+
+// Mismo formato que Expression::to_string
+std::string to_string(const Value& a);
+
+// Ejecuta el programa e imprime el resultado como lo hace main
+int run(Value (*program)());
+
+} // namespace aot
@@ -0,0 +1,240 @@
+#include "array_sort.hpp"
+#include "expression.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Por debajo de esto las mitades del merge sort ya no se reparten
+constexpr std::size_t kParallelLeaf = 1 << 15;
+// Por debajo de esto radix sort no compensa sus 256 contadores por pasada
+constexpr std::size_t kRadixMinimum = 64;
+
+template <typename Key>
+struct Item {
+    Key key;
+    std::uint32_t index;  // posición en el array original
+};
+
+struct RealLess {
+    // Orden total: los NaN son iguales entre sí y mayores que todo
+    bool operator()(double a, double b) const noexcept
+    {
+        return a < b || (!std::isnan(a) && std::isnan(b));
+    }
+
+    template <typename Entry>
+    bool operator()(const Entry& a, const Entry& b) const noexcept
+    {
+        return (*this)(a.key, b.key);
+    }
+};
+
+struct StringLess {
+    template <typename Entry>
+    bool operator()(const Entry& a, const Entry& b) const noexcept
+    {
+        return *a.key < *b.key;
+    }
+};
+
+struct IntLess {
+    template <typename Entry>
+    bool operator()(const Entry& a, const Entry& b) const noexcept
+    {
+        return a.key < b.key;
+    }
+};
+
+void radix_sort(Item<std::int32_t>* first, Item<std::int32_t>* last)
+{
+    std::size_t count = last - first;
+    if (count < kRadixMinimum) {
+        std::sort(first, last, IntLess{});
+        return;
+    }
+    std::vector<Item<std::int32_t>> buffer(count);
+    Item<std::int32_t>* from = first;
+    Item<std::int32_t>* to = buffer.data();
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        std::size_t offsets[256] = {};
+        for (auto* item = from; item != from + count; ++item) {
+            // El bit de signo invertido ordena los negativos primero
+            ++offsets[((static_cast<std::uint32_t>(item->key) ^ 0x80000000u) >> shift) & 0xff];
+        }
+        // Si todos comparten este byte la pasada no cambia nada
+        if (std::find(std::begin(offsets), std::end(offsets), count) != std::end(offsets)) continue;
+        std::size_t position = 0;
+        for (auto& offset : offsets) {
+            std::size_t bucket = offset;
+            offset = position;
+            position += bucket;
+        }
+        for (auto* item = from; item != from + count; ++item) {
+            to[offsets[((static_cast<std::uint32_t>(item->key) ^ 0x80000000u) >> shift) & 0xff]++] = *item;
+        }
+        std::swap(from, to);
+    }
+    if (from != first) {
+        std::copy(from, from + count, first);
+    }
+}
+
+// Merge sort con las dos mitades en paralelo; leaf ordena los tramos chicos
+template <typename Entry, typename Less, typename Leaf>
+void merge_sort(Entry* first, Entry* last, Entry* buffer, Less less, Leaf leaf)
+{
+    std::size_t count = last - first;
+    if (count <= kParallelLeaf) {
+        leaf(first, last);
+        return;
+    }
+    Entry* middle = first + count / 2;
+    parallel_invoke([&] { merge_sort(first, middle, buffer, less, leaf); },
+                    [&] { merge_sort(middle, last, buffer + (middle - first), less, leaf); });
+    std::merge(first, middle, middle, last, buffer, less);
+    std::copy(buffer, buffer + count, first);
+}
+
+template <typename Entry, typename Less, typename Leaf>
+void sort_items(std::vector<Entry>& items, Less less, Leaf leaf)
+{
+    if (parallel_enabled && items.size() > kParallelLeaf) {
+        std::vector<Entry> buffer(items.size());
+        merge_sort(items.data(), items.data() + items.size(), buffer.data(), less, leaf);
+    } else {
+        leaf(items.data(), items.data() + items.size());
+    }
+}
+
+template <typename Entry>
+std::vector<std::shared_ptr<Expression>> gather(const std::vector<Entry>& items,
+                                                const std::vector<std::shared_ptr<Expression>>& elements)
+{
+    std::vector<std::shared_ptr<Expression>> sorted;
+    sorted.reserve(items.size());
+    for (const auto& item : items) {
+        sorted.push_back(elements[item.index]);
+    }
+    return sorted;
+}
+
+template <typename Node>
+const Node& expect_element(const std::shared_ptr<Expression>& element)
+{
+    auto node = dynamic_cast<const Node*>(element.get());
+    if (!node) {
+        throw std::runtime_error("SortExpression: Array elements must all be int, real, string or bool of the same type");
+    }
+    return *node;
+}
+
+template <typename Node, typename Key>
+std::vector<Item<Key>> extract(const std::vector<std::shared_ptr<Expression>>& elements)
+{
+    std::vector<Item<Key>> items;
+    items.reserve(elements.size());
+    for (std::uint32_t i = 0; i < elements.size(); ++i) {
+        items.push_back({static_cast<Key>(expect_element<Node>(elements[i]).get_value()), i});
+    }
+    return items;
+}
+
+// -1, 0 o 1 según el orden de sort_elements
+int compare_values(const Expression& element, const Expression& value)
+{
+    const char* message = "BsearchExpression: Value must have the same type as the array elements";
+    if (auto a = dynamic_cast<const IntExpression*>(&element)) {
+        auto b = dynamic_cast<const IntExpression*>(&value);
+        if (!b) throw std::runtime_error(message);
+        return (a->get_value() > b->get_value()) - (a->get_value() < b->get_value());
+    }
+    if (auto a = dynamic_cast<const RealExpression*>(&element)) {
+        auto b = dynamic_cast<const RealExpression*>(&value);
+        if (!b) throw std::runtime_error(message);
+        RealLess less;
+        return less(b->get_value(), a->get_value()) - less(a->get_value(), b->get_value());
+    }
+    if (auto a = dynamic_cast<const StrExpression*>(&element)) {
+        auto b = dynamic_cast<const StrExpression*>(&value);
+        if (!b) throw std::runtime_error(message);
+        int order = a->get_value().compare(b->get_value());
+        return (order > 0) - (order < 0);
+    }
+    if (auto a = dynamic_cast<const BoolExpression*>(&element)) {
+        auto b = dynamic_cast<const BoolExpression*>(&value);
+        if (!b) throw std::runtime_error(message);
+        return a->get_value() - b->get_value();
+    }
+    throw std::runtime_error("BsearchExpression: Array elements must be int, real, string or bool");
+}
+
+} // namespace
+
+std::vector<std::shared_ptr<Expression>> sort_elements(const std::vector<std::shared_ptr<Expression>>& elements)
+{
+    if (elements.empty()) return {};
+    const Expression& first = *elements.front();
+
+    if (dynamic_cast<const IntExpression*>(&first)) {
+        auto items = extract<IntExpression, std::int32_t>(elements);
+        sort_items(items, IntLess{}, radix_sort);
+        return gather(items, elements);
+    }
+    if (dynamic_cast<const RealExpression*>(&first)) {
+        auto items = extract<RealExpression, double>(elements);
+        sort_items(items, RealLess{}, [](Item<double>* begin, Item<double>* end) {
+            std::sort(begin, end, RealLess{});
+        });
+        return gather(items, elements);
+    }
+    if (dynamic_cast<const StrExpression*>(&first)) {
+        std::vector<Item<const std::string*>> items;
+        items.reserve(elements.size());
+        for (std::uint32_t i = 0; i < elements.size(); ++i) {
+            items.push_back({&expect_element<StrExpression>(elements[i]).get_value(), i});
+        }
+        sort_items(items, StringLess{}, [](Item<const std::string*>* begin, Item<const std::string*>* end) {
+            std::sort(begin, end, StringLess{});
+        });
+        return gather(items, elements);
+    }
+    if (dynamic_cast<const BoolExpression*>(&first)) {
+        // Contando: primero los false, después los true
+        std::vector<std::shared_ptr<Expression>> sorted;
+        sorted.reserve(elements.size());
+        for (bool pass : {false, true}) {
+            for (const auto& element : elements) {
+                if (expect_element<BoolExpression>(element).get_value() == pass) {
+                    sorted.push_back(element);
+                }
+            }
+        }
+        return sorted;
+    }
+    expect_element<IntExpression>(elements.front());  // lanza el error
+    return {};
+}
+
+int search_sorted_elements(const std::vector<std::shared_ptr<Expression>>& elements, const Expression& value)
+{
+    std::size_t low = 0;
+    std::size_t high = elements.size();
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (compare_values(*elements[middle], value) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < elements.size() && compare_values(*elements[low], value) == 0) {
+        return static_cast<int>(low);
+    }
+    return -1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "utils.hpp"
+
+// sort y bsearch sobre arrays de int, real, string o bool. Los valores se
+// copian a un vector del tipo nativo junto con su posición, se ordena ese
+// vector y el resultado reusa los elementos originales (no se crean
+// expresiones nuevas). Los int se ordenan con radix sort (4 pasadas de 8
+// bits), los bool contando y los real y string con std::sort. Con
+// --parallel y arrays grandes se usa merge sort: las mitades se ordenan en
+// paralelo con parallel_invoke y después se mezclan.
+//
+// Los real NaN van al final. Lanza std::runtime_error si los elementos no
+// son todos del mismo tipo escalar.
+std::vector<std::shared_ptr<Expression>> sort_elements(const std::vector<std::shared_ptr<Expression>>& elements);
+
+// Posición de value en elements, que debe estar ordenado como lo deja
+// sort_elements; -1 si no está. Si se repite, la primera.
+int search_sorted_elements(const std::vector<std::shared_ptr<Expression>>& elements, const Expression& value);
@@ -0,0 +1,176 @@
+// Benchmarks del evaluador: cada workload se analiza y verifica una vez y
+// luego se evalúa en el mismo proceso con calentamiento y repeticiones.
+// El resultado se imprime en JSON por stdout.
+
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../expression.hpp"
+#include "../utils.hpp"
+#include "../scanner.hpp"
+#include "bench_util.hpp"
+
+extern int yyparse();
+extern Expression* parser_result;
+extern Environment global_env;
+extern void reset_parser_state();
+
+struct Workload {
+    std::string name;
+    std::vector<int> sizes;
+    std::function<std::string(int)> source;
+};
+
+// Nota: la función se llama "fib" y no "fibonacci" porque CallExpression::eval
+// reemplaza las llamadas a "fibonacci" por una versión iterativa.
+static std::string fib_source(int n)
+{
+    return "fun fib(x)\n"
+           "    if(x <= 1) x else fib(x - 1) + fib(x - 2) end\n"
+           "end\n"
+           "fib(" + std::to_string(n) + ")\n";
+}
+
+static std::string factorial_source(int n)
+{
+    return "fun factorial(x)\n"
+           "    if(x <= 1.0) 1.0 else x * factorial(x - 1.0) end\n"
+           "end\n"
+           "factorial(" + std::to_string(n) + ".0)\n";
+}
+
+static std::string array_sum_source(int n)
+{
+    std::string elements;
+    for (int i = 1; i <= n; ++i) {
+        if (i > 1) elements += ", ";
+        elements += std::to_string(i);
+    }
+    return "fun suma(x)\n"
+           "    if(length(x) == 1) head(x) else head(x) + suma(tail(x)) end\n"
+           "end\n"
+           "suma([" + elements + "])\n";
+}
+
+static std::string let_chain_source(int n)
+{
+    std::string program = "let v0 = 1 in\n";
+    for (int i = 1; i < n; ++i) {
+        program += "let v" + std::to_string(i) + " = v" + std::to_string(i - 1) + " + 1 in\n";
+    }
+    program += "v" + std::to_string(n - 1) + "\n";
+    for (int i = 0; i < n; ++i) {
+        program += "end\n";
+    }
+    return program;
+}
+
+static std::string concat_source(int n)
+{
+    return "fun repetir(x)\n"
+           "    if(x == 0) \"\" else \"ab\" # repetir(x - 1) end\n"
+           "end\n"
+           "repetir(" + std::to_string(n) + ")\n";
+}
+
+static std::string pair_source(int n)
+{
+    return "fun pares(x)\n"
+           "    if(x == 0) 0 else let p = (x, x * 2) in fst(p) + snd(p) + pares(x - 1) end end\n"
+           "end\n"
+           "pares(" + std::to_string(n) + ")\n";
+}
+
+static std::vector<Workload> workloads()
+{
+    return {
+        {"fib", {10, 15, 20}, fib_source},
+        {"factorial", {10, 100, 500}, factorial_source},
+        {"array_head_tail", {50, 200, 800}, array_sum_source},
+        {"let_chain", {10, 20, 35}, let_chain_source},
+        {"string_concat", {50, 200, 800}, concat_source},
+        {"pairs", {50, 200, 800}, pair_source},
+    };
+}
+
+// Analiza y verifica un programa; devuelve el mensaje de error o "" si todo va bien
+static std::string prepare(const std::string& source)
+{
+    reset_parser_state();
+    scan_source_text(source);
+    int status = yyparse();
+    release_source_text();
+    if (status != 0 || parser_result == nullptr) {
+        return "parse failed";
+    }
+    auto [type_ok, type_result] = parser_result->type_check(global_env);
+    if (!type_ok) {
+        return "type check failed";
+    }
+    return "";
+}
+
+int main(int argc, char* argv[])
+{
+    bench::Options options;
+    if (!bench::parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    PerfCounters counters;
+    if (options.perf && !counters.open()) {
+        fprintf(stderr, "hardware counters unavailable (%s)\n", counters.error().c_str());
+    }
+
+    printf("{\n  \"benchmark\": \"eval\",\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"perf_counters\": %s,\n  \"results\": [",
+           options.warmup, options.repetitions, counters.is_open() ? "true" : "false");
+
+    bool first = true;
+    for (const auto& workload : workloads()) {
+        if (!options.filter.empty() && workload.name != options.filter) {
+            continue;
+        }
+        for (int n : workload.sizes) {
+            fprintf(stderr, "%s n=%d\n", workload.name.c_str(), n);
+            printf("%s\n    {\"workload\": \"%s\", \"n\": %d, ", first ? "" : ",", workload.name.c_str(), n);
+            first = false;
+
+            std::string error = prepare(workload.source(n));
+            if (!error.empty()) {
+                printf("\"error\": \"%s\"}", bench::json_escape(error).c_str());
+                continue;
+            }
+
+            std::string result;
+            std::vector<std::int64_t> samples;
+            PerfCounts perf_total;
+            try {
+                for (int i = 0; i < options.warmup; ++i) {
+                    parser_result->eval(global_env);
+                }
+                for (int i = 0; i < options.repetitions; ++i) {
+                    auto perf_start = counters.read();
+                    auto start = bench::now_ns();
+                    auto value = parser_result->eval(global_env);
+                    samples.push_back(bench::now_ns() - start);
+                    perf_total += counters.read() - perf_start;
+                    result = value->to_string();
+                }
+            } catch (const std::exception& e) {
+                printf("\"error\": \"%s\"}", bench::json_escape(e.what()).c_str());
+                continue;
+            }
+
+            printf("%s, \"result\": \"%s\"",
+                   bench::summary_json(bench::summarize(samples)).c_str(),
+                   bench::json_escape(bench::truncate(result)).c_str());
+            if (counters.is_open()) {
+                printf(", %s", bench::perf_json(perf_total, options.repetitions).c_str());
+            }
+            printf("}");
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,253 @@
+// Benchmarks del front-end: mide por separado yylex, yyparse (incluye el
+// registro de funciones de create_statement_sequence) y el type check sobre
+// programas sintéticos de tamaño creciente. Imprime JSON por stdout con
+// tokens/s, nodos/s y el exponente de escalamiento entre tamaños sucesivos.
+
+#include <stdio.h>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../expression.hpp"
+#include "../utils.hpp"
+#include "../scanner.hpp"
+#include "bench_util.hpp"
+
+extern int yylex();
+extern int yyparse();
+extern Expression* parser_result;
+extern Environment global_env;
+extern void reset_parser_state();
+
+struct Family {
+    std::string name;
+    std::vector<int> sizes;
+    std::function<std::string(int)> source;
+};
+
+// [0, 1, 2, ..., n-1]: ejercita la regla elements del parser
+static std::string array_literal_source(int n)
+{
+    std::string program = "length([";
+    for (int i = 0; i < n; ++i) {
+        if (i > 0) program += ", ";
+        program += std::to_string(i);
+    }
+    return program + "])\n";
+}
+
+// n declaraciones independientes y una llamada a la última
+static std::string fun_declarations_source(int n)
+{
+    std::string program;
+    for (int i = 0; i < n; ++i) {
+        program += "fun f" + std::to_string(i) + "(x) x + " + std::to_string(i) + " end\n";
+    }
+    return program + "f" + std::to_string(n - 1) + "(1)\n";
+}
+
+// let/if anidados n niveles
+static std::string nested_let_if_source(int n)
+{
+    std::string program;
+    for (int i = 0; i < n; ++i) {
+        std::string v = "v" + std::to_string(i);
+        program += "let " + v + " = " + std::to_string(i) + " in if(" + v + " >= 0)\n";
+    }
+    program += "0\n";
+    for (int i = 0; i < n; ++i) {
+        program += "else 1 end end\n";
+    }
+    return program;
+}
+
+// c0 .. c(n-1) donde cada función llama a la anterior
+static std::string call_chain_source(int n)
+{
+    std::string program = "fun c0(x) x + 1 end\n";
+    for (int i = 1; i < n; ++i) {
+        program += "fun c" + std::to_string(i) + "(x) c" + std::to_string(i - 1) + "(x) + 1 end\n";
+    }
+    return program + "c" + std::to_string(n - 1) + "(0)\n";
+}
+
+static std::vector<Family> families()
+{
+    return {
+        {"array_literal", {1000, 2000, 4000, 8000}, array_literal_source},
+        {"fun_declarations", {250, 500, 1000, 2000}, fun_declarations_source},
+        {"nested_let_if", {100, 200, 400, 800}, nested_let_if_source},
+        {"call_chain", {25, 50, 100, 200}, call_chain_source},
+    };
+}
+
+// Cuenta los nodos del AST alcanzables desde expr
+static std::size_t count_nodes(const std::shared_ptr<Expression>& expr);
+
+static std::size_t count_nodes(const Expression* expr)
+{
+    if (expr == nullptr) return 0;
+    std::size_t count = 1;
+    if (auto unary = dynamic_cast<const UnaryExpression*>(expr)) {
+        count += count_nodes(unary->get_expression());
+    } else if (auto binary = dynamic_cast<const BinaryExpression*>(expr)) {
+        count += count_nodes(binary->get_left_expression());
+        count += count_nodes(binary->get_right_expression());
+    } else if (auto if_expr = dynamic_cast<const IfElseExpression*>(expr)) {
+        count += count_nodes(if_expr->get_condition_expression());
+        count += count_nodes(if_expr->get_true_expression());
+        count += count_nodes(if_expr->get_false_expression());
+    } else if (auto let_expr = dynamic_cast<const LetExpression*>(expr)) {
+        for (const auto& [var_name, var_expression] : let_expr->get_bindings()) {
+            count += count_nodes(var_name);
+            count += count_nodes(var_expression);
+        }
+        count += count_nodes(let_expr->get_body_expression());
+    } else if (auto array_expr = dynamic_cast<const ArrayExpression*>(expr)) {
+        for (const auto& element : array_expr->get_elements()) {
+            count += count_nodes(element);
+        }
+    }
+    return count;
+}
+
+static std::size_t count_nodes(const std::shared_ptr<Expression>& expr)
+{
+    return count_nodes(expr.get());
+}
+
+// Nodos del programa: la expresión final más el cuerpo de cada función registrada
+static std::size_t program_nodes()
+{
+    std::size_t count = count_nodes(parser_result);
+    for (const auto& [name, value] : global_env) {
+        if (auto closure = std::dynamic_pointer_cast<Closure>(value)) {
+            count += 1 + count_nodes(closure->get_body_expression());
+        }
+    }
+    return count;
+}
+
+struct PhaseResult {
+    bench::Summary summary;
+    std::size_t units = 0;   // tokens o nodos procesados por iteración
+    bool ok = true;
+    PerfCounts perf;
+};
+
+static PerfCounters counters;
+
+template <typename Setup, typename Run>
+static PhaseResult measure(const bench::Options& options, Setup setup, Run run)
+{
+    PhaseResult result;
+    std::vector<std::int64_t> samples;
+    for (int i = 0; i < options.warmup + options.repetitions; ++i) {
+        setup();
+        auto perf_start = counters.read();
+        auto start = bench::now_ns();
+        result.ok = run(result.units) && result.ok;
+        auto elapsed = bench::now_ns() - start;
+        if (i >= options.warmup) {
+            samples.push_back(elapsed);
+            result.perf += counters.read() - perf_start;
+        }
+    }
+    result.summary = bench::summarize(samples);
+    return result;
+}
+
+static std::string phase_json(const char* phase, const PhaseResult& r, const char* unit, int repetitions)
+{
+    char buffer[256];
+    double per_second = r.summary.median_ns > 0 ? r.units * 1e9 / r.summary.median_ns : 0.0;
+    snprintf(buffer, sizeof buffer, "\"%s\": {\"ok\": %s, \"%s\": %zu, \"%s_per_second\": %.0f, ",
+             phase, r.ok ? "true" : "false", unit, r.units, unit, per_second);
+    std::string json = buffer + bench::summary_json(r.summary);
+    if (counters.is_open()) {
+        json += ", " + bench::perf_json(r.perf, repetitions);
+    }
+    return json + "}";
+}
+
+// Exponente k tal que tiempo ~ n^k entre dos tamaños consecutivos
+static double scaling_exponent(int n0, std::int64_t t0, int n1, std::int64_t t1)
+{
+    if (t0 <= 0 || t1 <= 0 || n0 == n1) return 0.0;
+    return std::log(static_cast<double>(t1) / t0) / std::log(static_cast<double>(n1) / n0);
+}
+
+int main(int argc, char* argv[])
+{
+    bench::Options options;
+    if (!bench::parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    if (options.perf && !counters.open()) {
+        fprintf(stderr, "hardware counters unavailable (%s)\n", counters.error().c_str());
+    }
+
+    printf("{\n  \"benchmark\": \"frontend\",\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"perf_counters\": %s,\n  \"results\": [",
+           options.warmup, options.repetitions, counters.is_open() ? "true" : "false");
+
+    bool first = true;
+    for (const auto& family : families()) {
+        if (!options.filter.empty() && family.name != options.filter) {
+            continue;
+        }
+        int previous_n = 0;
+        std::int64_t previous[3] = {0, 0, 0};
+        for (int n : family.sizes) {
+            fprintf(stderr, "%s n=%d\n", family.name.c_str(), n);
+            std::string source = family.source(n);
+
+            auto lex = measure(options,
+                [&] { scan_source_text(source); },
+                [&](std::size_t& tokens) {
+                    tokens = 0;
+                    while (yylex() != 0) ++tokens;
+                    return true;
+                });
+
+            auto parse = measure(options,
+                [&] { reset_parser_state(); scan_source_text(source); },
+                [&](std::size_t& nodes) {
+                    bool ok = yyparse() == 0 && parser_result != nullptr;
+                    nodes = ok ? program_nodes() : 0;
+                    return ok;
+                });
+
+            // El type check se mide sobre el último programa analizado
+            std::size_t nodes = parse.units;
+            auto check = measure(options,
+                [] {},
+                [&](std::size_t& units) {
+                    units = nodes;
+                    return parser_result != nullptr && parser_result->type_check(global_env).first;
+                });
+            release_source_text();
+
+            printf("%s\n    {\"family\": \"%s\", \"n\": %d, \"bytes\": %zu,\n      %s,\n      %s,\n      %s",
+                   first ? "" : ",", family.name.c_str(), n, source.size(),
+                   phase_json("lex", lex, "tokens", options.repetitions).c_str(),
+                   phase_json("parse", parse, "nodes", options.repetitions).c_str(),
+                   phase_json("type_check", check, "nodes", options.repetitions).c_str());
+            first = false;
+
+            std::int64_t current[3] = {lex.summary.median_ns, parse.summary.median_ns, check.summary.median_ns};
+            if (previous_n != 0) {
+                printf(",\n      \"scaling_exponent\": {\"lex\": %.2f, \"parse\": %.2f, \"type_check\": %.2f}",
+                       scaling_exponent(previous_n, previous[0], n, current[0]),
+                       scaling_exponent(previous_n, previous[1], n, current[1]),
+                       scaling_exponent(previous_n, previous[2], n, current[2]));
+            }
+            printf("}");
+            previous_n = n;
+            std::copy(current, current + 3, previous);
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
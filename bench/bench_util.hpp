@@ -0,0 +1,156 @@
+#pragma once
+
+// Utilidades comunes de los benchmarks: reloj, estadísticas y salida JSON
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../perf_counters.hpp"
+
+namespace bench {
+
+inline std::int64_t now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Resumen de una serie de mediciones (en nanosegundos)
+struct Summary {
+    std::int64_t min_ns = 0;
+    std::int64_t max_ns = 0;
+    std::int64_t median_ns = 0;
+    std::int64_t p95_ns = 0;
+    double mean_ns = 0.0;
+};
+
+// Percentil por rango más cercano sobre una serie ya ordenada
+inline std::int64_t percentile(const std::vector<std::int64_t>& sorted, double p) noexcept
+{
+    if (sorted.empty()) return 0;
+    auto rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+inline Summary summarize(std::vector<std::int64_t> samples)
+{
+    Summary s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    s.min_ns = samples.front();
+    s.max_ns = samples.back();
+    s.median_ns = percentile(samples, 0.5);
+    s.p95_ns = percentile(samples, 0.95);
+    double total = 0.0;
+    for (auto v : samples) total += static_cast<double>(v);
+    s.mean_ns = total / samples.size();
+    return s;
+}
+
+inline std::string json_escape(const std::string& text)
+{
+    std::string out;
+    out.reserve(text.size() + 2);
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// Recorta textos largos (resultados) para que el JSON siga siendo legible
+inline std::string truncate(const std::string& text, std::size_t limit = 80)
+{
+    return text.size() <= limit ? text : text.substr(0, limit) + "...";
+}
+
+inline std::string summary_json(const Summary& s)
+{
+    std::ostringstream out;
+    out << "\"min_ns\": " << s.min_ns
+        << ", \"median_ns\": " << s.median_ns
+        << ", \"p95_ns\": " << s.p95_ns
+        << ", \"max_ns\": " << s.max_ns
+        << ", \"mean_ns\": " << static_cast<std::int64_t>(s.mean_ns);
+    return out.str();
+}
+
+// Contadores de hardware promediados por iteración medida; "null" si no hay
+inline std::string perf_json(const PerfCounts& total, int iterations)
+{
+    std::ostringstream out;
+    out << "\"perf\": {";
+    for (int e = 0; e < PerfEventCount; ++e) {
+        out << (e == 0 ? "" : ", ") << "\"" << perf_event_name(static_cast<PerfEvent>(e)) << "\": ";
+        if (total.present[e] && iterations > 0) {
+            out << total.values[e] / static_cast<std::uint64_t>(iterations);
+        } else {
+            out << "null";
+        }
+    }
+    auto rate = [&](const char* name, double value) {
+        out << ", \"" << name << "\": ";
+        if (value < 0) {
+            out << "null";
+        } else {
+            char buffer[32];
+            std::snprintf(buffer, sizeof buffer, "%.4f", value);
+            out << buffer;
+        }
+    };
+    rate("ipc", total.ipc());
+    rate("l1d_mpki", total.per_kilo_instruction(PerfL1dMisses));
+    rate("llc_mpki", total.per_kilo_instruction(PerfLlcMisses));
+    rate("branch_mpki", total.per_kilo_instruction(PerfBranchMisses));
+    out << "}";
+    return out.str();
+}
+
+// Opciones de línea de comandos compartidas por los benchmarks
+struct Options {
+    int warmup = 3;
+    int repetitions = 10;
+    std::string filter;
+    bool perf = false;
+};
+
+inline bool parse_options(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::atoi(argv[++i]);
+        } else if (arg == "--reps" && i + 1 < argc) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--perf") {
+            options.perf = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--warmup N] [--reps N] [--filter WORKLOAD] [--perf]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace bench
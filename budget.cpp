@@ -0,0 +1,51 @@
+#include "budget.hpp"
+#include "profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+bool budget_enabled = false;
+
+namespace {
+
+// Leer el reloj en cada llamada costaría más que la llamada misma
+constexpr std::uint64_t kClockInterval = 256;
+
+EvalBudget active_budget;
+std::chrono::steady_clock::time_point deadline;
+// Atómico: con --parallel varios hilos hacen llamadas a la vez
+std::atomic<std::uint64_t> steps{0};
+
+} // namespace
+
+void start_budget(const EvalBudget& budget) noexcept
+{
+    active_budget = budget;
+    steps = 0;
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{budget.max_time_ms};
+    if (budget.max_bytes > 0) {
+        allocation_counting = true;
+    }
+    budget_enabled = budget.max_steps > 0 || budget.max_time_ms > 0 || budget.max_bytes > 0;
+}
+
+void stop_budget() noexcept
+{
+    budget_enabled = false;
+}
+
+void charge_budget_step()
+{
+    std::uint64_t step = steps.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (active_budget.max_steps > 0 && step > active_budget.max_steps) {
+        throw BudgetExceeded{"step limit of " + std::to_string(active_budget.max_steps) + " calls exceeded"};
+    }
+    if (active_budget.max_bytes > 0 && live_allocated_bytes() > active_budget.max_bytes) {
+        throw BudgetExceeded{"memory limit of " + std::to_string(active_budget.max_bytes) + " bytes exceeded"};
+    }
+    if (active_budget.max_time_ms > 0 && step % kClockInterval == 0 &&
+        std::chrono::steady_clock::now() > deadline) {
+        throw BudgetExceeded{"time limit of " + std::to_string(active_budget.max_time_ms) + " ms exceeded"};
+    }
+}
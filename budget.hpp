@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+// Presupuesto de evaluación (--max-steps, --max-time-ms, --max-bytes): un
+// programa que se pasa de alguno de los límites se aborta con
+// BudgetExceeded, que es distinto de los errores de evaluación. Los límites
+// se revisan en cada llamada a función y en cada elemento de range, map,
+// filter y fold, los únicos lugares donde se repite trabajo. Con
+// budget_enabled en false cada revisión solo cuesta una comparación.
+struct EvalBudget {
+    std::uint64_t max_steps = 0;  // llamadas; 0 es sin límite
+    long max_time_ms = 0;         // tiempo de reloj; 0 es sin límite
+    std::uint64_t max_bytes = 0;  // bytes vivos asignados; 0 es sin límite
+};
+
+class BudgetExceeded : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+extern bool budget_enabled;
+
+// Empieza a contar desde ahora. Con max_bytes activa allocation_counting.
+void start_budget(const EvalBudget& budget) noexcept;
+
+void stop_budget() noexcept;
+
+// Lanza BudgetExceeded si se agotó algún límite
+void charge_budget_step();
+
+inline void charge_budget()
+{
+    if (budget_enabled) charge_budget_step();
+}
@@ -0,0 +1,784 @@
+#include "closure_compiler.hpp"
+#include "array_sort.hpp"
+#include "budget.hpp"
+#include "expression.hpp"
+#include "jit.hpp"
+#include "profiler.hpp"
+#include "sampler.hpp"
+#include "trace.hpp"
+#include "value_equality.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Value = std::shared_ptr<Expression>;
+
+// Código compilado: recibe la base del marco actual dentro de slot_stack
+using Code = std::function<Value(std::size_t)>;
+
+// Pila de marcos: cada llamada reserva frame_size posiciones al final. Se
+// accede por índice porque el vector puede crecer durante una llamada.
+thread_local std::vector<Value> slot_stack;
+
+// Libera el marco de la llamada al salir (también si hay una excepción)
+class FrameGuard
+{
+public:
+    explicit FrameGuard(std::size_t _base) noexcept : base{_base} {}
+    ~FrameGuard() { slot_stack.resize(base); }
+
+    FrameGuard(const FrameGuard&) = delete;
+    FrameGuard& operator=(const FrameGuard&) = delete;
+
+private:
+    std::size_t base;
+};
+
+template <typename T>
+bool is(const Value& value) noexcept
+{
+    return value != nullptr && typeid(*value) == typeid(T);
+}
+
+// Solo después de comprobar el tipo con is<T>
+template <typename T>
+const T& as(const Value& value) noexcept
+{
+    return static_cast<const T&>(*value);
+}
+
+template <typename T>
+const T& expect(const Value& value, const char* message)
+{
+    auto result = std::dynamic_pointer_cast<T>(value);
+    if (!result) {
+        throw std::runtime_error(message);
+    }
+    return *result;
+}
+
+// Los booleanos no cambian nunca: se comparten en lugar de crear uno por operación
+const Value true_value = std::make_shared<BoolExpression>(true);
+const Value false_value = std::make_shared<BoolExpression>(false);
+
+Value make_bool(bool value)
+{
+    return value ? true_value : false_value;
+}
+
+bool bool_value(const Value& value, const char* message)
+{
+    if (is<BoolExpression>(value)) return as<BoolExpression>(value).get_value();
+    return expect<BoolExpression>(value, message).get_value();
+}
+
+double real_value(const Value& value, const char* message)
+{
+    if (is<RealExpression>(value)) return as<RealExpression>(value).get_value();
+    return expect<RealExpression>(value, message).get_value();
+}
+
+int int_value(const Value& value, const char* message)
+{
+    if (is<IntExpression>(value)) return as<IntExpression>(value).get_value();
+    return expect<IntExpression>(value, message).get_value();
+}
+
+// Igual que los eval de + - * /: enteros si ambos lo son, reales si no
+template <typename Op>
+Code arithmetic(Code left, Code right, Op op, const char* message)
+{
+    return [left, right, op, message](std::size_t base) -> Value {
+        Value a = left(base);
+        Value b = right(base);
+        if (is<IntExpression>(a) && is<IntExpression>(b)) {
+            return std::make_shared<IntExpression>(op(as<IntExpression>(a).get_value(), as<IntExpression>(b).get_value()));
+        }
+        return std::make_shared<RealExpression>(op(real_value(a, message), real_value(b, message)));
+    };
+}
+
+template <typename Op>
+Code comparison(Code left, Code right, Op op, const char* message)
+{
+    return [left, right, op, message](std::size_t base) -> Value {
+        Value a = left(base);
+        Value b = right(base);
+        if (is<IntExpression>(a) && is<IntExpression>(b)) {
+            return make_bool(op(as<IntExpression>(a).get_value(), as<IntExpression>(b).get_value()));
+        }
+        return make_bool(op(real_value(a, message), real_value(b, message)));
+    };
+}
+
+template <typename Op>
+Code logical(Code left, Code right, Op op, const char* message)
+{
+    return [left, right, op, message](std::size_t base) -> Value {
+        Value a = left(base);
+        Value b = right(base);
+        return make_bool(op(bool_value(a, message), bool_value(b, message)));
+    };
+}
+
+bool values_equal(const Value& a, const Value& b)
+{
+    // La misma comparación estructural que el intérprete, sin crear nodos
+    return equal_values(*a, *b);
+}
+
+struct CompiledFunction {
+    std::string name;
+    std::shared_ptr<Closure> closure;
+    Code body;
+    std::size_t frame_size = 1;
+    const Environment* globals = nullptr;
+    // Entrada de la tabla que --jit reemplaza por la versión nativa
+    long calls = 0;
+    bool jit_attempted = false;
+    NativeFunction native;
+    // Buffers de call_native; se dimensionan en la primera llamada
+    std::vector<Datatype> argument_types;
+    std::vector<JitScalar> native_arguments;
+};
+
+// Variables visibles en el punto que se compila y su posición en el marco
+struct Scope {
+    std::vector<std::pair<std::string, std::size_t>> bindings;
+    std::size_t next_slot = 0;
+    std::size_t frame_size = 0;
+
+    std::size_t push(const std::string& name)
+    {
+        std::size_t slot = next_slot++;
+        frame_size = std::max(frame_size, next_slot);
+        bindings.emplace_back(name, slot);
+        return slot;
+    }
+
+    void pop() noexcept
+    {
+        bindings.pop_back();
+        --next_slot;
+    }
+
+    const std::size_t* lookup(const std::string& name) const noexcept
+    {
+        for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+            if (it->first == name) return &it->second;
+        }
+        return nullptr;
+    }
+};
+
+Datatype scalar_type(const Value& value) noexcept
+{
+    if (is<IntExpression>(value)) return Datatype::IntType;
+    if (is<RealExpression>(value)) return Datatype::RealType;
+    if (is<BoolExpression>(value)) return Datatype::BoolType;
+    return Datatype::UnknownType;
+}
+
+// Con --jit, pasado el umbral de llamadas se intenta compilar la función a
+// código nativo; si no se puede se queda en este backend para siempre.
+// Los argumentos están en los primeros slots del marco callee.
+bool call_native(CompiledFunction& fn, std::size_t callee, Value& result)
+{
+    std::size_t arity = fn.closure->get_parameter_names().size();
+    std::vector<Datatype>& types = fn.argument_types;
+    types.resize(arity);
+    for (std::size_t i = 0; i < arity; ++i) {
+        types[i] = scalar_type(slot_stack[callee + i]);
+    }
+    bool scalar = std::find(types.begin(), types.end(), Datatype::UnknownType) == types.end();
+    if (!fn.jit_attempted && ++fn.calls >= jit_threshold && scalar) {
+        fn.jit_attempted = true;
+        std::string reason;
+        if (!jit_compile(fn.name, types, *fn.globals, fn.native, reason)) {
+            fprintf(stderr, "jit: %s stays in the closure backend (%s)\n", fn.name.c_str(), reason.c_str());
+        }
+    }
+    if (fn.native.entry == nullptr || types != fn.native.parameter_types) {
+        return false;
+    }
+    std::vector<JitScalar>& in = fn.native_arguments;
+    in.resize(arity);
+    JitScalar out;
+    for (std::size_t i = 0; i < arity; ++i) {
+        const Value& argument = slot_stack[callee + i];
+        switch (types[i]) {
+            case Datatype::IntType: in[i].i = as<IntExpression>(argument).get_value(); break;
+            case Datatype::RealType: in[i].r = as<RealExpression>(argument).get_value(); break;
+            default: in[i].b = as<BoolExpression>(argument).get_value(); break;
+        }
+    }
+    fn.native.entry(in.data(), &out);
+    switch (fn.native.return_type) {
+        case Datatype::IntType: result = std::make_shared<IntExpression>(out.i); break;
+        case Datatype::RealType: result = std::make_shared<RealExpression>(out.r); break;
+        default: result = make_bool(out.b); break;
+    }
+    return true;
+}
+
+// Llama al cuerpo compilado de fn. Los argumentos se evalúan en el marco
+// del llamador (base) y se guardan en los primeros slots del nuevo marco.
+Value call_compiled(CompiledFunction& fn, const std::vector<Code>& arguments, std::size_t base)
+{
+    charge_budget();
+    std::size_t callee = slot_stack.size();
+    slot_stack.resize(callee + std::max(fn.frame_size, arguments.size()));
+    FrameGuard frame{callee};
+    for (std::size_t i = 0; i < arguments.size(); ++i) {
+        // Un argumento puede llamar a otras funciones y hacer crecer la pila
+        Value value = arguments[i](base);
+        slot_stack[callee + i] = std::move(value);
+    }
+    ProfileScope function_profile{fn.name};
+    SampleScope function_sample{fn.name.c_str()};
+    TraceScope function_trace{"call", fn.name, true};
+    Value result;
+    if (jit_enabled && call_native(fn, callee, result)) {
+        return result;
+    }
+    return fn.body(callee);
+}
+
+class Compiler
+{
+public:
+    explicit Compiler(const Environment& _globals) : globals{_globals} {}
+
+    Code compile(const Expression& node, Scope& scope);
+
+private:
+    CompiledFunction* function(const std::string& name);
+
+    Code compile_call(const CallExpression& node, Scope& scope);
+    Code compile_let(const LetExpression& node, Scope& scope);
+    Code compile_name(const NameExpression& node, Scope& scope);
+    Code fallback(const Expression& node, Scope& scope);
+
+    const Environment& globals;
+    std::unordered_map<std::string, std::unique_ptr<CompiledFunction>> functions;
+
+    friend class ClosureProgram;
+};
+
+CompiledFunction* Compiler::function(const std::string& name)
+{
+    auto found = functions.find(name);
+    if (found != functions.end()) {
+        return found->second.get();
+    }
+    auto closure = std::dynamic_pointer_cast<Closure>(globals.lookup(name));
+    if (!closure) {
+        return nullptr;
+    }
+    // Se registra antes de compilar el cuerpo para que la recursión lo encuentre
+    auto& fn = functions[name];
+    fn = std::make_unique<CompiledFunction>();
+    fn->name = name;
+    fn->closure = closure;
+    fn->globals = &globals;
+    Scope scope;
+    for (const auto& parameter : closure->get_parameter_names()) {
+        scope.push(parameter);
+    }
+    fn->body = compile(*closure->get_body_expression(), scope);
+    fn->frame_size = scope.frame_size;
+    return fn.get();
+}
+
+Code Compiler::compile_name(const NameExpression& node, Scope& scope)
+{
+    if (auto slot = scope.lookup(node.get_name())) {
+        std::size_t index = *slot;
+        return [index](std::size_t base) { return slot_stack[base + index]; };
+    }
+    if (auto value = globals.lookup(node.get_name())) {
+        return [value](std::size_t) { return value; };
+    }
+    std::string message = "Undefined variable: " + node.get_name();
+    return [message](std::size_t) -> Value { throw std::runtime_error(message); };
+}
+
+Code Compiler::compile_let(const LetExpression& node, Scope& scope)
+{
+    // letrec crea closures locales: se deja al intérprete
+    if (node.is_recursive()) {
+        return fallback(node, scope);
+    }
+    // Cada variable toma el siguiente slot del marco actual
+    std::vector<std::pair<Code, std::size_t>> values;
+    for (const auto& [var_name, var_expression] : node.get_bindings()) {
+        auto name = std::dynamic_pointer_cast<NameExpression>(var_name);
+        if (!name) {
+            for (std::size_t i = 0; i < values.size(); ++i) scope.pop();
+            return [](std::size_t) -> Value { throw std::runtime_error("Let expression requires a variable name"); };
+        }
+        // La variable no es visible en su propia definición
+        Code value = compile(*var_expression, scope);
+        values.emplace_back(std::move(value), scope.push(name->get_name()));
+    }
+    Code body = compile(*node.get_body_expression(), scope);
+    for (std::size_t i = 0; i < values.size(); ++i) scope.pop();
+    if (values.size() == 1) {
+        Code value = values.front().first;
+        std::size_t slot = values.front().second;
+        return [value, body, slot](std::size_t base) {
+            Value bound = value(base);
+            slot_stack[base + slot] = std::move(bound);
+            return body(base);
+        };
+    }
+    return [values, body](std::size_t base) {
+        for (const auto& [value, slot] : values) {
+            Value bound = value(base);
+            slot_stack[base + slot] = std::move(bound);
+        }
+        return body(base);
+    };
+}
+
+Code Compiler::compile_call(const CallExpression& node, Scope& scope)
+{
+    auto name_expr = std::dynamic_pointer_cast<NameExpression>(node.get_left_expression());
+    std::vector<Code> arguments;
+    for (const auto& argument : node.get_arguments()) {
+        arguments.push_back(compile(*argument, scope));
+    }
+    const std::string& name = name_expr->get_name();
+
+    // Un nombre local que guarda un closure: se llama con el intérprete
+    if (auto slot = scope.lookup(name)) {
+        std::size_t index = *slot;
+        std::string message = "function " + name + " does not exist";
+        std::string arity_message = "function " + name + " expects ";
+        return [index, arguments, message, arity_message](std::size_t base) {
+            auto closure = std::dynamic_pointer_cast<Closure>(slot_stack[base + index]);
+            if (!closure) {
+                throw std::runtime_error(message);
+            }
+            const auto& parameters = closure->get_parameter_names();
+            if (parameters.size() != arguments.size()) {
+                throw std::runtime_error(arity_message + std::to_string(parameters.size()) + " arguments");
+            }
+            std::vector<Value> values;
+            for (const auto& argument : arguments) {
+                values.push_back(argument(base));
+            }
+            Environment env = closure->get_environment();
+            for (std::size_t i = 0; i < parameters.size(); ++i) {
+                env.add(parameters[i], values[i]);
+            }
+            return closure->get_body_expression()->eval(env);
+        };
+    }
+
+    CompiledFunction* fn = function(name);
+    if (fn == nullptr) {
+        std::string message = "function " + name + " does not exist";
+        return [message](std::size_t) -> Value { throw std::runtime_error(message); };
+    }
+    if (fn->closure->get_parameter_names().size() != arguments.size()) {
+        std::string message = "function " + name + " expects " + std::to_string(fn->closure->get_parameter_names().size()) + " arguments";
+        return [message](std::size_t) -> Value { throw std::runtime_error(message); };
+    }
+    return [fn, arguments](std::size_t base) {
+        return call_compiled(*fn, arguments, base);
+    };
+}
+
+// Evalúa el nodo con el intérprete en un entorno con las variables visibles
+Code Compiler::fallback(const Expression& node, Scope& scope)
+{
+    const Expression* target = &node;
+    auto bindings = scope.bindings;
+    const Environment* global_scope = &globals;
+    return [target, bindings, global_scope](std::size_t base) {
+        Environment env = *global_scope;
+        for (const auto& [name, slot] : bindings) {
+            env.add(name, slot_stack[base + slot]);
+        }
+        return target->eval(env);
+    };
+}
+
+Code Compiler::compile(const Expression& node, Scope& scope)
+{
+    // Literales: el valor se crea una sola vez
+    if (auto n = dynamic_cast<const IntExpression*>(&node)) {
+        Value value = std::make_shared<IntExpression>(n->get_value());
+        return [value](std::size_t) { return value; };
+    }
+    if (auto n = dynamic_cast<const RealExpression*>(&node)) {
+        Value value = std::make_shared<RealExpression>(n->get_value());
+        return [value](std::size_t) { return value; };
+    }
+    if (auto n = dynamic_cast<const BoolExpression*>(&node)) {
+        Value value = make_bool(n->get_value());
+        return [value](std::size_t) { return value; };
+    }
+    if (auto n = dynamic_cast<const StrExpression*>(&node)) {
+        Value value = std::make_shared<StrExpression>(n->get_value());
+        return [value](std::size_t) { return value; };
+    }
+    if (auto n = dynamic_cast<const NameExpression*>(&node)) {
+        return compile_name(*n, scope);
+    }
+    if (auto n = dynamic_cast<const LetExpression*>(&node)) {
+        return compile_let(*n, scope);
+    }
+    if (auto n = dynamic_cast<const CallExpression*>(&node)) {
+        return compile_call(*n, scope);
+    }
+    if (auto n = dynamic_cast<const IfElseExpression*>(&node)) {
+        Code condition = compile(*n->get_condition_expression(), scope);
+        Code if_true = compile(*n->get_true_expression(), scope);
+        Code if_false = compile(*n->get_false_expression(), scope);
+        return [condition, if_true, if_false](std::size_t base) {
+            Value result = condition(base);
+            bool taken = is<BoolExpression>(result) ? as<BoolExpression>(result).get_value()
+                : std::dynamic_pointer_cast<BoolExpression>(result) && std::dynamic_pointer_cast<BoolExpression>(result)->get_value();
+            return taken ? if_true(base) : if_false(base);
+        };
+    }
+    if (auto n = dynamic_cast<const ArrayExpression*>(&node)) {
+        std::vector<Code> elements;
+        for (const auto& element : n->get_elements()) {
+            elements.push_back(compile(*element, scope));
+        }
+        return [elements](std::size_t base) -> Value {
+            std::vector<Value> values;
+            values.reserve(elements.size());
+            for (const auto& element : elements) {
+                values.push_back(element(base));
+            }
+            return std::make_shared<ArrayExpression>(values);
+        };
+    }
+    if (auto n = dynamic_cast<const TupleExpression*>(&node)) {
+        std::vector<Code> elements;
+        for (const auto& element : n->get_elements()) {
+            elements.push_back(compile(*element, scope));
+        }
+        return [elements](std::size_t base) -> Value {
+            std::vector<Value> values;
+            values.reserve(elements.size());
+            for (const auto& element : elements) {
+                values.push_back(element(base));
+            }
+            return std::make_shared<TupleExpression>(std::move(values));
+        };
+    }
+
+    if (auto n = dynamic_cast<const BinaryExpression*>(&node)) {
+        // Las asignaciones modifican el entorno: quedan para el intérprete
+        if (dynamic_cast<const AssignmentExpression*>(&node)) {
+            return fallback(node, scope);
+        }
+        Code left = compile(*n->get_left_expression(), scope);
+        Code right = compile(*n->get_right_expression(), scope);
+
+        if (dynamic_cast<const AddExpression*>(&node)) {
+            return arithmetic(left, right, [](auto a, auto b) { return a + b; }, "Type error: Cannot add incompatible types");
+        }
+        if (dynamic_cast<const SubExpression*>(&node)) {
+            return arithmetic(left, right, [](auto a, auto b) { return a - b; }, "Type error: Cannot subtract incompatible types");
+        }
+        if (dynamic_cast<const MulExpression*>(&node)) {
+            return arithmetic(left, right, [](auto a, auto b) { return a * b; }, "Type error: Cannot multiply incompatible types");
+        }
+        if (dynamic_cast<const DivExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value a = left(base);
+                Value b = right(base);
+                if (is<IntExpression>(a) && is<IntExpression>(b)) {
+                    int divisor = as<IntExpression>(b).get_value();
+                    if (divisor == 0) {
+                        throw std::runtime_error("Division by zero");
+                    }
+                    return std::make_shared<IntExpression>(as<IntExpression>(a).get_value() / divisor);
+                }
+                const char* message = "Type error: Cannot divide incompatible types";
+                return std::make_shared<RealExpression>(real_value(a, message) / real_value(b, message));
+            };
+        }
+        if (dynamic_cast<const ModExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                const char* message = "Type error: Modulo requires integers";
+                int a = int_value(left(base), message);
+                int b = int_value(right(base), message);
+                if (b == 0) {
+                    throw std::runtime_error("Division by zero");
+                }
+                return std::make_shared<IntExpression>(a % b);
+            };
+        }
+        if (dynamic_cast<const LessExpression*>(&node)) {
+            return comparison(left, right, [](auto a, auto b) { return a < b; }, "Type error: Cannot compare incompatible types");
+        }
+        if (dynamic_cast<const LessEqExpression*>(&node)) {
+            return comparison(left, right, [](auto a, auto b) { return a <= b; }, "Type error: Cannot compare incompatible types");
+        }
+        if (dynamic_cast<const GreaterExpression*>(&node)) {
+            return comparison(left, right, [](auto a, auto b) { return a > b; }, "Type error: Cannot compare incompatible types");
+        }
+        if (dynamic_cast<const GreaterEqExpression*>(&node)) {
+            return comparison(left, right, [](auto a, auto b) { return a >= b; }, "Type error: Cannot compare incompatible types");
+        }
+        if (dynamic_cast<const EqualExpression*>(&node)) {
+            return [left, right](std::size_t base) {
+                Value a = left(base);
+                Value b = right(base);
+                return make_bool(values_equal(a, b));
+            };
+        }
+        if (dynamic_cast<const NotEqualExpression*>(&node)) {
+            return [left, right](std::size_t base) {
+                Value a = left(base);
+                Value b = right(base);
+                return make_bool(!values_equal(a, b));
+            };
+        }
+        if (dynamic_cast<const AndExpression*>(&node)) {
+            return logical(left, right, [](bool a, bool b) { return a && b; }, "Type error: and requires booleans");
+        }
+        if (dynamic_cast<const OrExpression*>(&node)) {
+            return logical(left, right, [](bool a, bool b) { return a || b; }, "Type error: or requires booleans");
+        }
+        if (dynamic_cast<const XorExpression*>(&node)) {
+            return logical(left, right, [](bool a, bool b) { return a != b; }, "Type error: xor requires booleans");
+        }
+        if (dynamic_cast<const ConcatExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value a = left(base);
+                Value b = right(base);
+                const char* message = "Type error: # requires strings";
+                return std::make_shared<StrExpression>(expect<StrExpression>(a, message).get_value()
+                                                       + expect<StrExpression>(b, message).get_value());
+            };
+        }
+        if (dynamic_cast<const PairExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value a = left(base);
+                Value b = right(base);
+                return std::make_shared<PairExpression>(a, b);
+            };
+        }
+        if (dynamic_cast<const ArrayAddExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value array = left(base);
+                Value element = right(base);
+                auto elements = expect<ArrayExpression>(array, "ArrayAddExpression: First operand must be an array").get_elements();
+                elements.push_back(element);
+                return std::make_shared<ArrayExpression>(elements);
+            };
+        }
+        if (dynamic_cast<const ArrayDelExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value array = left(base);
+                Value index_value = right(base);
+                const auto& elements = expect<ArrayExpression>(array, "ArrayDelExpression: First operand must be an array").get_elements();
+                int index = expect<IntExpression>(index_value, "ArrayDelExpression: Index must be an integer").get_value();
+                if (index < 0 || index >= static_cast<int>(elements.size())) {
+                    throw std::runtime_error("ArrayDelExpression: Index out of bounds");
+                }
+                std::vector<Value> remaining;
+                remaining.reserve(elements.size() - 1);
+                for (std::size_t i = 0; i < elements.size(); ++i) {
+                    if (static_cast<int>(i) != index) remaining.push_back(elements[i]);
+                }
+                return std::make_shared<ArrayExpression>(remaining);
+            };
+        }
+        if (dynamic_cast<const IndexExpression*>(&node)) {
+            return [left, right](std::size_t base) {
+                Value array = left(base);
+                Value index_value = right(base);
+                const auto& elements = expect<ArrayExpression>(array, "IndexExpression: First operand must be an array").get_elements();
+                int index = expect<IntExpression>(index_value, "IndexExpression: Index must be an integer").get_value();
+                if (index < 0 || index >= static_cast<int>(elements.size())) {
+                    throw std::runtime_error("IndexExpression: Index out of bounds");
+                }
+                return elements[index];
+            };
+        }
+        if (dynamic_cast<const BsearchExpression*>(&node)) {
+            return [left, right](std::size_t base) -> Value {
+                Value array = left(base);
+                Value value = right(base);
+                const auto& elements = expect<ArrayExpression>(array, "BsearchExpression: First operand must be an array").get_elements();
+                return std::make_shared<IntExpression>(search_sorted_elements(elements, *value));
+            };
+        }
+        return fallback(node, scope);
+    }
+
+    if (auto n = dynamic_cast<const UnaryExpression*>(&node)) {
+        // length de range/map/filter cuenta sin crear el array
+        if (dynamic_cast<const LengthExpression*>(&node) && is_sequence_expression(*n->get_expression())) {
+            return fallback(node, scope);
+        }
+        Code operand = compile(*n->get_expression(), scope);
+
+        if (dynamic_cast<const NotExpression*>(&node)) {
+            return [operand](std::size_t base) {
+                return make_bool(!bool_value(operand(base), "Type error: not requires a boolean"));
+            };
+        }
+        if (dynamic_cast<const NegExpression*>(&node)) {
+            // Como en NegExpression::eval, el negativo de un real se trunca a entero
+            return [operand](std::size_t base) -> Value {
+                Value value = operand(base);
+                if (is<IntExpression>(value)) {
+                    return std::make_shared<IntExpression>(-as<IntExpression>(value).get_value());
+                }
+                return std::make_shared<IntExpression>(-real_value(value, "Type error: Cannot negate a non-numeric value"));
+            };
+        }
+        if (dynamic_cast<const FstExpression*>(&node)) {
+            return [operand](std::size_t base) {
+                Value pair = operand(base);
+                return expect<PairExpression>(pair, "FstExpression: Operand must be a pair").get_left_expression();
+            };
+        }
+        if (dynamic_cast<const SndExpression*>(&node)) {
+            return [operand](std::size_t base) {
+                Value pair = operand(base);
+                return expect<PairExpression>(pair, "SndExpression: Operand must be a pair").get_right_expression();
+            };
+        }
+        if (auto field = dynamic_cast<const TupleFieldExpression*>(&node)) {
+            std::size_t index = field->get_index();
+            return [operand, index](std::size_t base) {
+                Value tuple = operand(base);
+                const auto& elements = expect<TupleExpression>(tuple, "TupleFieldExpression: Operand must be a tuple").get_elements();
+                if (index >= elements.size()) {
+                    throw std::runtime_error("TupleFieldExpression: Field out of range");
+                }
+                return elements[index];
+            };
+        }
+        if (dynamic_cast<const HeadExpression*>(&node)) {
+            return [operand](std::size_t base) {
+                Value array = operand(base);
+                const auto& elements = expect<ArrayExpression>(array, "HeadExpression: Operand must be an array or pair").get_elements();
+                if (elements.empty()) {
+                    throw std::runtime_error("HeadExpression: Cannot get head of empty array");
+                }
+                return elements[0];
+            };
+        }
+        if (dynamic_cast<const TailExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                Value array = operand(base);
+                const auto& elements = expect<ArrayExpression>(array, "TailExpression: Operand must be an array or pair").get_elements();
+                if (elements.empty()) {
+                    throw std::runtime_error("TailExpression: Cannot get tail of empty array");
+                }
+                return std::make_shared<ArrayExpression>(std::vector<Value>(elements.begin() + 1, elements.end()));
+            };
+        }
+        if (dynamic_cast<const LengthExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                Value array = operand(base);
+                const auto& elements = expect<ArrayExpression>(array, "LengthExpression: Operand must be an array").get_elements();
+                return std::make_shared<IntExpression>(static_cast<int>(elements.size()));
+            };
+        }
+        if (dynamic_cast<const SortExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                Value array = operand(base);
+                const auto& elements = expect<ArrayExpression>(array, "SortExpression: Operand must be an array").get_elements();
+                return std::make_shared<ArrayExpression>(sort_elements(elements));
+            };
+        }
+        if (dynamic_cast<const RtoSExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                return std::make_shared<StrExpression>(std::to_string(real_value(operand(base), "Type error: rtos requires a real")));
+            };
+        }
+        if (dynamic_cast<const ItoSExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                return std::make_shared<StrExpression>(std::to_string(int_value(operand(base), "Type error: itos requires an int")));
+            };
+        }
+        if (dynamic_cast<const ItoRExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                return std::make_shared<RealExpression>(static_cast<double>(int_value(operand(base), "Type error: itor requires an int")));
+            };
+        }
+        if (dynamic_cast<const RtoIExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                return std::make_shared<IntExpression>(static_cast<int>(real_value(operand(base), "Type error: rtoi requires a real")));
+            };
+        }
+        if (dynamic_cast<const PrintExpression*>(&node)) {
+            return operand;
+        }
+        if (dynamic_cast<const UnitExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                Value value = operand(base);
+                return std::make_shared<IntExpression>(std::dynamic_pointer_cast<UnitExpression>(value) ? 1 : 0);
+            };
+        }
+        if (dynamic_cast<const IsUniTExpression*>(&node)) {
+            return [operand](std::size_t base) -> Value {
+                Value value = operand(base);
+                if (is<IntExpression>(value)) {
+                    return std::make_shared<IntExpression>(as<IntExpression>(value).get_value() == 0 ? 1 : 0);
+                }
+                return std::make_shared<IntExpression>(0);
+            };
+        }
+        return fallback(node, scope);
+    }
+
+    // FunExpression, Closure y cualquier nodo nuevo
+    return fallback(node, scope);
+}
+
+class ClosureProgram : public CompiledProgram
+{
+public:
+    ClosureProgram(const Expression& program, const Environment& globals)
+        : compiler{globals}
+    {
+        body = compiler.compile(program, scope);
+    }
+
+    Value run() override
+    {
+        std::size_t base = slot_stack.size();
+        slot_stack.resize(base + scope.frame_size);
+        FrameGuard frame{base};
+        return body(base);
+    }
+
+private:
+    Compiler compiler;
+    Scope scope;
+    Code body;
+};
+
+} // namespace
+
+CompiledProgram::~CompiledProgram()
+{
+    // empty
+}
+
+std::unique_ptr<CompiledProgram> compile_program(const Expression& program, const Environment& globals)
+{
+    return std::make_unique<ClosureProgram>(program, globals);
+}
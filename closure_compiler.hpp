@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include "utils.hpp"
+
+// Backend de closures compiladas (--backend=closure). Antes de evaluar, cada
+// nodo del programa ya verificado se traduce a una función de C++ que captura
+// las funciones de sus hijos:
+//  - las variables (parámetros y let) se resuelven a posiciones de un marco,
+//    sin búsquedas por nombre ni copias de Environment;
+//  - las llamadas a funciones globales apuntan directo a la función
+//    compilada del destino;
+//  - las operaciones revisan el tipo de sus operandos con typeid en lugar de
+//    varios dynamic_pointer_cast.
+// Los valores siguen siendo nodos Expression, así que los resultados se
+// imprimen igual que con el intérprete. Lo que no se sabe compilar (fun
+// anidadas, asignaciones) se evalúa con eval en un entorno reconstruido.
+class CompiledProgram
+{
+public:
+    virtual ~CompiledProgram();
+
+    virtual std::shared_ptr<Expression> run() = 0;
+};
+
+// globals es el entorno con las funciones registradas por el parser. El AST
+// del programa debe vivir mientras se use el resultado.
+std::unique_ptr<CompiledProgram> compile_program(const Expression& program, const Environment& globals);
@@ -1,13 +1,26 @@
 #include "utils.hpp"
 #include "expression.hpp"
+#include "profiler.hpp"
+#include "sampler.hpp"
+#include "trace.hpp"
+#include "budget.hpp"
+#include "lazy_let.hpp"
+#include "array_sort.hpp"
+#include "value_equality.hpp"
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
 #include <unordered_map>
 
 // Declaración externa de la función que está en main.cpp
 extern std::string datatype_to_string(Datatype type) noexcept;
 
+// Elementos de una cadena range/map/filter sin crear el array (está junto a
+// run_sequence, más abajo)
+std::size_t count_sequence(const Expression& sequence, Environment& env);
+
 // Función auxiliar para crear placeholders recursivos de pares anidados
 std::shared_ptr<Expression> create_pair_placeholder_recursive(Datatype type, Environment& env) {
     switch (type) {
@@ -32,11 +45,23 @@ std::shared_ptr<Expression> create_pair_placeholder_recursive(Datatype type, Env
         case Datatype::BoolArrayType:
             // Para arrays, crear un array vacío
             return std::make_shared<ArrayExpression>(std::vector<std::shared_ptr<Expression>>());
+        case Datatype::TupleType:
+            // Sin la expresión no se conocen los campos
+            return std::make_shared<TupleExpression>(std::vector<std::shared_ptr<Expression>>());
         default:
             return std::make_shared<IntExpression>(0); // fallback
     }
 }
 
+// Como create_pair_placeholder_recursive, pero una tupla conserva sus campos
+std::shared_ptr<Expression> create_field_placeholder(std::shared_ptr<Expression> field, Datatype type, Environment& env)
+{
+    if (type == Datatype::TupleType) {
+        if (auto shape = infer_tuple_shape(field, env)) return shape;
+    }
+    return create_pair_placeholder_recursive(type, env);
+}
+
 // Función auxiliar para inferir tipos de elementos de un par de manera inteligente
 // Función auxiliar para hacer type checking estricto en funciones
 std::pair<bool, Datatype> strict_type_check_for_functions(std::shared_ptr<Expression> expr, Environment& env) {
@@ -86,18 +111,21 @@ bool contains_itos_or_concat(std::shared_ptr<Expression> expr) {
                contains_itos_or_concat(if_expr->get_false_expression());
     }
     
+    // Verificar si es una llamada a función (antes que BinaryExpression,
+    // porque guarda todos los argumentos)
+    if (auto call_expr = std::dynamic_pointer_cast<CallExpression>(expr)) {
+        for (const auto& argument : call_expr->get_arguments()) {
+            if (contains_itos_or_concat(argument)) return true;
+        }
+        return false;
+    }
+    
     // Verificar si es una expresión binaria (como concatenación)
     if (auto bin_expr = std::dynamic_pointer_cast<BinaryExpression>(expr)) {
         return contains_itos_or_concat(bin_expr->get_left_expression()) ||
                contains_itos_or_concat(bin_expr->get_right_expression());
     }
     
-    // Verificar si es una llamada a función
-    if (auto call_expr = std::dynamic_pointer_cast<CallExpression>(expr)) {
-        return contains_itos_or_concat(call_expr->get_left_expression()) ||
-               contains_itos_or_concat(call_expr->get_right_expression());
-    }
-    
     return false;
 }
 
@@ -147,6 +175,18 @@ Datatype infer_function_return_type(std::shared_ptr<Expression> body, Environmen
                 return Datatype::UnknownType; // Se inferirá correctamente en CallExpression::type_check
             } else if (auto pair_expr = std::dynamic_pointer_cast<PairExpression>(expr)) {
                 return Datatype::PairType; // pair() siempre retorna pair
+            } else if (std::dynamic_pointer_cast<TupleExpression>(expr)) {
+                return Datatype::TupleType;
+            } else if (std::dynamic_pointer_cast<MapLiteralExpression>(expr) ||
+                       std::dynamic_pointer_cast<MapPutExpression>(expr) ||
+                       std::dynamic_pointer_cast<MapRemoveExpression>(expr)) {
+                return Datatype::MapType;
+            } else if (auto name_expr = std::dynamic_pointer_cast<NameExpression>(expr)) {
+                // Solo los maps: los demás tipos siguen con las heurísticas de CallExpression
+                if (std::dynamic_pointer_cast<MapValue>(env.lookup(name_expr->get_name()))) {
+                    return Datatype::MapType;
+                }
+                return Datatype::UnknownType;
             } else if (auto int_expr = std::dynamic_pointer_cast<IntExpression>(expr)) {
                 return Datatype::IntType;
             } else if (auto real_expr = std::dynamic_pointer_cast<RealExpression>(expr)) {
@@ -191,6 +231,15 @@ Datatype infer_function_return_type(std::shared_ptr<Expression> body, Environmen
             }
         }
         
+        // Un map o una tupla en una rama y en la otra algo desconocido
+        // (normalmente la llamada recursiva)
+        for (Datatype known : {Datatype::MapType, Datatype::TupleType}) {
+            if ((true_type == known && false_type == Datatype::UnknownType) ||
+                (true_type == Datatype::UnknownType && false_type == known)) {
+                return known;
+            }
+        }
+
         // Si las ramas tienen tipos diferentes, retornar UnknownType
         // para que el type checker estricto pueda detectar el error
         return Datatype::UnknownType;
@@ -252,6 +301,7 @@ std::pair<Datatype, Datatype> infer_pair_element_types(std::shared_ptr<Expressio
 
 std::shared_ptr<Expression> NotExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto expr = get_expression()->eval(env);
     auto bool_expr = std::dynamic_pointer_cast<BoolExpression>(expr);
     return std::make_shared<BoolExpression>(!bool_expr->get_value());
@@ -279,8 +329,8 @@ std::pair<bool, Datatype> NotExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> AndExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
 
     auto left_bool = std::dynamic_pointer_cast<BoolExpression>(left);
     auto right_bool = std::dynamic_pointer_cast<BoolExpression>(right);
@@ -308,8 +358,8 @@ std::pair<bool, Datatype> AndExpression::type_check(Environment& env) const noex
 }
 
 std::shared_ptr<Expression> XorExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_bool = std::dynamic_pointer_cast<BoolExpression>(left_result);
     auto right_bool = std::dynamic_pointer_cast<BoolExpression>(right_result);
@@ -342,8 +392,8 @@ std::pair<bool, Datatype> XorExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> OrExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
 
     auto left_bool = std::dynamic_pointer_cast<BoolExpression>(left);
     auto right_bool = std::dynamic_pointer_cast<BoolExpression>(right);
@@ -371,8 +421,8 @@ std::pair<bool, Datatype> OrExpression::type_check(Environment& env) const noexc
 }
 
 std::shared_ptr<Expression> LessExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_int = std::dynamic_pointer_cast<IntExpression>(left_result);
     auto right_int = std::dynamic_pointer_cast<IntExpression>(right_result);
@@ -412,8 +462,8 @@ std::pair<bool, Datatype> LessExpression::type_check(Environment& env) const noe
 
 
 std::shared_ptr<Expression> LessEqExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_int = std::dynamic_pointer_cast<IntExpression>(left_result);
     auto right_int = std::dynamic_pointer_cast<IntExpression>(right_result);
@@ -451,8 +501,8 @@ std::pair<bool, Datatype> LessEqExpression::type_check(Environment& env) const n
 }
 
 std::shared_ptr<Expression> GreaterExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_int = std::dynamic_pointer_cast<IntExpression>(left_result);
     auto right_int = std::dynamic_pointer_cast<IntExpression>(right_result);
@@ -493,8 +543,8 @@ std::pair<bool, Datatype> GreaterExpression::type_check(Environment& env) const
 
 
 std::shared_ptr<Expression> GreaterEqExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_int = std::dynamic_pointer_cast<IntExpression>(left_result);
     auto right_int = std::dynamic_pointer_cast<IntExpression>(right_result);
@@ -533,54 +583,9 @@ std::pair<bool, Datatype> GreaterEqExpression::type_check(Environment& env) cons
 
 
 std::shared_ptr<Expression> EqualExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
-    
-    auto left_int = std::dynamic_pointer_cast<IntExpression>(left_result);
-    auto right_int = std::dynamic_pointer_cast<IntExpression>(right_result);
-    auto left_real = std::dynamic_pointer_cast<RealExpression>(left_result);
-    auto right_real = std::dynamic_pointer_cast<RealExpression>(right_result);
-    auto left_bool = std::dynamic_pointer_cast<BoolExpression>(left_result);
-    auto right_bool = std::dynamic_pointer_cast<BoolExpression>(right_result);
-    auto left_str = std::dynamic_pointer_cast<StrExpression>(left_result);
-    auto right_str = std::dynamic_pointer_cast<StrExpression>(right_result);
-    auto left_array = std::dynamic_pointer_cast<ArrayExpression>(left_result);
-    auto right_array = std::dynamic_pointer_cast<ArrayExpression>(right_result);
-    
-    if (left_int && right_int) {
-        return std::make_shared<BoolExpression>(left_int->get_value() == right_int->get_value());
-    }
-    else if (left_real && right_real) {
-        return std::make_shared<BoolExpression>(left_real->get_value() == right_real->get_value());
-    }
-    else if (left_bool && right_bool) {
-        return std::make_shared<BoolExpression>(left_bool->get_value() == right_bool->get_value());
-    }
-    else if (left_str && right_str) {
-        return std::make_shared<BoolExpression>(left_str->get_value() == right_str->get_value());
-    }
-    else if (left_array && right_array) {
-        // Comparar arrays: deben tener el mismo tamaño y elementos iguales
-        const auto& left_elements = left_array->get_elements();
-        const auto& right_elements = right_array->get_elements();
-        
-        if (left_elements.size() != right_elements.size()) {
-            return std::make_shared<BoolExpression>(false);
-        }
-        
-        for (size_t i = 0; i < left_elements.size(); ++i) {
-            // Comparar elementos recursivamente
-            auto elem_equal = EqualExpression(left_elements[i], right_elements[i]).eval(env);
-            auto elem_bool = std::dynamic_pointer_cast<BoolExpression>(elem_equal);
-            if (!elem_bool || !elem_bool->get_value()) {
-                return std::make_shared<BoolExpression>(false);
-            }
-        }
-        
-        return std::make_shared<BoolExpression>(true);
-    }
-    
-    return std::make_shared<BoolExpression>(false);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
+    return std::make_shared<BoolExpression>(equal_values(*left_result, *right_result));
 }
 
 std::string EqualExpression::to_string() const noexcept {
@@ -605,10 +610,9 @@ std::pair<bool, Datatype> EqualExpression::type_check(Environment& env) const no
 }
 
 std::shared_ptr<Expression> NotEqualExpression::eval(Environment& env) const {
-    auto equal_result = EqualExpression(get_left_expression(), get_right_expression()).eval(env);
-    
-    auto equal_bool = std::dynamic_pointer_cast<BoolExpression>(equal_result);
-    return std::make_shared<BoolExpression>(!equal_bool->get_value());
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
+    return std::make_shared<BoolExpression>(!equal_values(*left_result, *right_result));
 }
 
 std::string NotEqualExpression::to_string() const noexcept {
@@ -634,8 +638,8 @@ std::pair<bool, Datatype> NotEqualExpression::type_check(Environment& env) const
 
 std::shared_ptr<Expression> AddExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
     
 
    auto left_int = std::dynamic_pointer_cast<IntExpression>(left);
@@ -681,8 +685,8 @@ std::pair<bool, Datatype> AddExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> SubExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
 
    auto left_int = std::dynamic_pointer_cast<IntExpression>(left);
    auto right_int = std::dynamic_pointer_cast<IntExpression>(right);
@@ -719,8 +723,8 @@ std::pair<bool, Datatype> SubExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> MulExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
 
    auto left_int = std::dynamic_pointer_cast<IntExpression>(left);
    auto right_int = std::dynamic_pointer_cast<IntExpression>(right);
@@ -757,8 +761,8 @@ std::pair<bool, Datatype> MulExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> DivExpression::eval(Environment& env) const
 {
-   auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+   auto [left, right] = eval_operands(env);
 
    auto left_int = std::dynamic_pointer_cast<IntExpression>(left);
    auto right_int = std::dynamic_pointer_cast<IntExpression>(right);
@@ -798,8 +802,8 @@ std::pair<bool, Datatype> DivExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> ModExpression::eval(Environment& env) const
 {
-    auto left = get_left_expression()->eval(env);
-    auto right = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
 
    auto left_int = std::dynamic_pointer_cast<IntExpression>(left);
    auto right_int = std::dynamic_pointer_cast<IntExpression>(right);
@@ -830,6 +834,7 @@ std::pair<bool, Datatype> ModExpression::type_check(Environment& env) const noex
 
 
 std::shared_ptr<Expression> AssignmentExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
     auto right_value = get_right_expression()->eval(env);
     auto left_name_expr = std::dynamic_pointer_cast<NameExpression>(get_left_expression());
     
@@ -870,14 +875,25 @@ const std::string& NameExpression::get_name() const noexcept {
     return name;
 }
 
+// --lazy-let: una variable perezosa se evalúa la primera vez que se lee,
+// también cuando se la llama como función
+std::shared_ptr<Expression> force_lazy(std::shared_ptr<Expression> value)
+{
+    if (lazy_let_enabled && value != nullptr && typeid(*value) == typeid(ThunkExpression)) {
+        return static_cast<const ThunkExpression&>(*value).force();
+    }
+    return value;
+}
+
 std::shared_ptr<Expression> NameExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
     auto value = env.lookup(name);
     
     if (value == nullptr) {
         throw std::runtime_error("Undefined variable: " + name);
     }
-    
-    return value;
+
+    return force_lazy(std::move(value));
 }
 
 std::string NameExpression::to_string() const noexcept {
@@ -932,6 +948,12 @@ std::pair<bool, Datatype> NameExpression::type_check(Environment& env) const noe
                 if (pair_expr) {
                     return {true, Datatype::PairType};
                 }
+                if (std::dynamic_pointer_cast<MapValue>(expr)) {
+                    return {true, Datatype::MapType};
+                }
+                if (std::dynamic_pointer_cast<TupleExpression>(expr)) {
+                    return {true, Datatype::TupleType};
+                }
                 // Si no se puede determinar el tipo, asumir int
                 return {true, Datatype::IntType};
             }
@@ -988,6 +1010,7 @@ double RealExpression::get_value() const noexcept
 }
 
 std::shared_ptr<Expression> RealExpression::eval(Environment&) const {
+    ProfileScope profile{*this};
     return std::make_shared<RealExpression>(value);
 }
 
@@ -1010,6 +1033,7 @@ int IntExpression::get_value() const noexcept
 
 std::shared_ptr<Expression> IntExpression::eval(Environment&) const
 {
+    ProfileScope profile{*this};
     return std::make_shared<IntExpression>(value);
 }
 
@@ -1032,6 +1056,7 @@ bool BoolExpression::get_value() const noexcept
 }
 
 std::shared_ptr<Expression> BoolExpression::eval(Environment&) const {
+    ProfileScope profile{*this};
     return std::make_shared<BoolExpression>(value);
 }
 
@@ -1052,6 +1077,7 @@ const std::string& StrExpression::get_value() const noexcept {
 }
 
 std::shared_ptr<Expression> StrExpression::eval(Environment&) const {
+    ProfileScope profile{*this};
     return std::make_shared<StrExpression>(value);
 }
 
@@ -1066,10 +1092,9 @@ std::pair<bool, Datatype> StrExpression::type_check(Environment&) const noexcept
 
 std::shared_ptr<Expression> PairExpression::eval(Environment& env) const
 {
-    return std::make_shared<PairExpression>(
-        BinaryExpression::get_left_expression()->eval(env),
-        BinaryExpression::get_right_expression()->eval(env)
-    );
+    ProfileScope profile{*this};
+    auto [left, right] = eval_operands(env);
+    return std::make_shared<PairExpression>(left, right);
 }
 
 std::string PairExpression::to_string() const noexcept
@@ -1092,8 +1117,8 @@ std::pair<bool, Datatype> PairExpression::type_check(Environment& env) const noe
 
 
 std::shared_ptr<Expression> ConcatExpression::eval(Environment& env) const {
-    auto left_result = get_left_expression()->eval(env);
-    auto right_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [left_result, right_result] = eval_operands(env);
     
     auto left_str = std::dynamic_pointer_cast<StrExpression>(left_result);
     auto right_str = std::dynamic_pointer_cast<StrExpression>(right_result);
@@ -1126,6 +1151,7 @@ std::pair<bool, Datatype> ConcatExpression::type_check(Environment& env) const n
 
 std::shared_ptr<Expression> NegExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
    auto _int = std::dynamic_pointer_cast<IntExpression>(UnaryExpression::get_expression()->eval(env));
    auto _real = std::dynamic_pointer_cast<RealExpression>(UnaryExpression::get_expression()->eval(env));
     if(_int != nullptr)
@@ -1154,8 +1180,19 @@ std::pair<bool, Datatype> NegExpression::type_check(Environment& env) const noex
 }
 
 
+// Par guardado en un campo de tupla (t.N), con placeholders de sus elementos
+std::shared_ptr<PairExpression> infer_field_pair(const std::shared_ptr<Expression>& expr, Environment& env)
+{
+    auto field = std::dynamic_pointer_cast<TupleFieldExpression>(expr);
+    if (!field) return nullptr;
+    auto shape = infer_tuple_shape(field->get_expression(), env);
+    if (!shape || field->get_index() >= shape->get_elements().size()) return nullptr;
+    return std::dynamic_pointer_cast<PairExpression>(shape->get_elements()[field->get_index()]);
+}
+
 std::shared_ptr<Expression> FstExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<PairExpression>(UnaryExpression::get_expression()->eval(env));
 
     return result->get_left_expression();
@@ -1205,6 +1242,9 @@ std::pair<bool, Datatype> FstExpression::type_check(Environment& env) const noex
         }
         // Si es una expresión anidada que evalúa a un par (como snd(...), fst(...), etc.)
         else {
+            if (auto field_pair = infer_field_pair(get_expression(), env)) {
+                return field_pair->get_left_expression()->type_check(env);
+            }
             // Caso especial: fst(snd(...))
             if (auto snd_expr = std::dynamic_pointer_cast<SndExpression>(get_expression())) {
                 auto [snd_ok, snd_type] = snd_expr->get_expression()->type_check(env);
@@ -1250,6 +1290,7 @@ std::pair<bool, Datatype> FstExpression::type_check(Environment& env) const noex
 
 std::shared_ptr<Expression> SndExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<PairExpression>(UnaryExpression::get_expression()->eval(env));
 
     return result->get_right_expression();
@@ -1303,6 +1344,9 @@ std::pair<bool, Datatype> SndExpression::type_check(Environment& env) const noex
         }
         // Si es una expresión anidada que evalúa a un par (como snd(...), fst(...), etc.)
         else {
+            if (auto field_pair = infer_field_pair(get_expression(), env)) {
+                return field_pair->get_right_expression()->type_check(env);
+            }
             // Para expresiones anidadas, usar la función auxiliar para inferir el tipo
             auto [nested_ok, nested_type] = infer_nested_pair_type(get_expression(), env, false);
             if (nested_ok) {
@@ -1316,8 +1360,91 @@ std::pair<bool, Datatype> SndExpression::type_check(Environment& env) const noex
 
 
 
+TupleExpression::TupleExpression(std::vector<std::shared_ptr<Expression>> _elements) noexcept
+    : elements{std::move(_elements)}
+{
+    // empty
+}
+
+const std::vector<std::shared_ptr<Expression>>& TupleExpression::get_elements() const noexcept
+{
+    return elements;
+}
+
+std::shared_ptr<Expression> TupleExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    std::vector<std::shared_ptr<Expression>> values;
+    values.reserve(elements.size());
+    for (const auto& element : elements) {
+        values.push_back(element->eval(env));
+    }
+    return std::make_shared<TupleExpression>(std::move(values));
+}
+
+std::string TupleExpression::to_string() const noexcept
+{
+    std::string result = "(tuple";
+    for (const auto& element : elements) {
+        result += element->to_string();
+    }
+    return result + ")";
+}
+
+std::pair<bool, Datatype> TupleExpression::type_check(Environment& env) const noexcept
+{
+    for (const auto& element : elements) {
+        auto [element_ok, element_type] = element->type_check(env);
+        if (!element_ok) return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::TupleType};
+}
+
+TupleFieldExpression::TupleFieldExpression(std::shared_ptr<Expression> _tuple_expression, std::size_t _index) noexcept
+    : UnaryExpression{_tuple_expression}, index{_index}
+{
+    // empty
+}
+
+std::size_t TupleFieldExpression::get_index() const noexcept
+{
+    return index;
+}
+
+std::shared_ptr<Expression> TupleFieldExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto tuple = std::dynamic_pointer_cast<TupleExpression>(get_expression()->eval(env));
+    if (!tuple) {
+        throw std::runtime_error("TupleFieldExpression: Operand must be a tuple");
+    }
+    if (index >= tuple->get_elements().size()) {
+        throw std::runtime_error("TupleFieldExpression: Field out of range");
+    }
+    return tuple->get_elements()[index];
+}
+
+std::string TupleFieldExpression::to_string() const noexcept
+{
+    return "(field " + get_expression()->to_string() + " " + std::to_string(index) + ")";
+}
+
+std::pair<bool, Datatype> TupleFieldExpression::type_check(Environment& env) const noexcept
+{
+    auto [tuple_ok, tuple_type] = get_expression()->type_check(env);
+    if (!tuple_ok || tuple_type != Datatype::TupleType) return {false, Datatype::UnknownType};
+
+    // El tipo del campo sale de la forma de la tupla, sin recorrer pares anidados
+    auto shape = infer_tuple_shape(get_expression(), env);
+    if (!shape || index >= shape->get_elements().size()) return {false, Datatype::UnknownType};
+    return shape->get_elements()[index]->type_check(env);
+}
+
+
+
 std::shared_ptr<Expression> HeadExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = UnaryExpression::get_expression()->eval(env);
     // Verificar si es un ArrayExpression
     auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(result);
@@ -1368,6 +1495,7 @@ std::pair<bool, Datatype> HeadExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> TailExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = UnaryExpression::get_expression()->eval(env);
     
     // Verificar si es un ArrayExpression
@@ -1415,6 +1543,7 @@ std::pair<bool, Datatype> TailExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> RtoSExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<RealExpression>(UnaryExpression::get_expression()->eval(env));
 
     return std::make_shared<StrExpression>(std::to_string(result->get_value()));
@@ -1441,6 +1570,7 @@ std::pair<bool, Datatype> RtoSExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> ItoSExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<IntExpression>(UnaryExpression::get_expression()->eval(env));
 
     return std::make_shared<StrExpression>(std::to_string(result->get_value()));
@@ -1467,6 +1597,7 @@ std::pair<bool, Datatype> ItoSExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> ItoRExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<IntExpression>(UnaryExpression::get_expression()->eval(env));
 
     return std::make_shared<RealExpression>(static_cast<double>(result->get_value()));
@@ -1493,6 +1624,7 @@ std::pair<bool, Datatype> ItoRExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> RtoIExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = std::dynamic_pointer_cast<RealExpression>(UnaryExpression::get_expression()->eval(env));
 
     return std::make_shared<IntExpression>(static_cast<int>(result->get_value()));
@@ -1539,6 +1671,7 @@ std::shared_ptr<Expression> IfElseExpression::get_false_expression() const noexc
     
 std::shared_ptr<Expression> IfElseExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto condition_result = condition_expression->eval(env);
     auto condition_bool = std::dynamic_pointer_cast<BoolExpression>(condition_result);
 
@@ -1585,10 +1718,10 @@ std::pair<bool, Datatype> IfElseExpression::type_check(Environment& env) const n
 }
 
 FunExpression::FunExpression(std::shared_ptr<Expression> _function_name_expression, 
-                            std::shared_ptr<Expression> _parameter_name_expression, 
+                            std::vector<std::shared_ptr<Expression>> _parameter_name_expressions, 
                             std::shared_ptr<Expression> _body_expression) noexcept
     : function_name_expression(_function_name_expression), 
-      parameter_name_expression(_parameter_name_expression),
+      parameter_name_expressions(_parameter_name_expressions),
       body_expression(_body_expression) {}
 
 
@@ -1597,8 +1730,8 @@ std::shared_ptr<Expression> FunExpression::get_function_name_expression() const
     return function_name_expression;
 }
 
-std::shared_ptr<Expression> FunExpression::get_parameter_name_expression() const noexcept {
-    return parameter_name_expression;
+const std::vector<std::shared_ptr<Expression>>& FunExpression::get_parameter_name_expressions() const noexcept {
+    return parameter_name_expressions;
 }
 
 std::string FunExpression::get_name() const noexcept {
@@ -1606,9 +1739,13 @@ std::string FunExpression::get_name() const noexcept {
     return name_expr ? name_expr->get_name() : "";
 }
 
-std::string FunExpression::get_parameter_name() const noexcept {
-    auto param_expr = std::dynamic_pointer_cast<NameExpression>(parameter_name_expression);
-    return param_expr ? param_expr->get_name() : "";
+std::vector<std::string> FunExpression::get_parameter_names() const noexcept {
+    std::vector<std::string> names;
+    for (const auto& parameter : parameter_name_expressions) {
+        auto param_expr = std::dynamic_pointer_cast<NameExpression>(parameter);
+        names.push_back(param_expr ? param_expr->get_name() : "unknown");
+    }
+    return names;
 }
 
 std::shared_ptr<Expression> FunExpression::get_body_expression() const noexcept {
@@ -1617,7 +1754,7 @@ std::shared_ptr<Expression> FunExpression::get_body_expression() const noexcept
 
 // Función auxiliar para inferir tipos de funciones
 std::pair<Datatype, Datatype> infer_function_types(std::shared_ptr<Expression> body, 
-                                                  std::string param_name, 
+                                                  const std::vector<std::string>& param_names, 
                                                   Environment& env) {
     // En la declaración, no podemos saber el tipo del parámetro
     // Solo almacenamos la función y verificaremos en el call
@@ -1625,26 +1762,30 @@ std::pair<Datatype, Datatype> infer_function_types(std::shared_ptr<Expression> b
 }
 
 std::shared_ptr<Expression> FunExpression::eval(Environment& env) const {
-    // Obtener el nombre del parámetro
-    auto param_name_expr = std::dynamic_pointer_cast<NameExpression>(parameter_name_expression);
-    std::string param_name = param_name_expr ? param_name_expr->get_name() : "unknown";
+    ProfileScope profile{*this};
+    // Obtener los nombres de los parámetros
+    auto param_names = get_parameter_names();
     
     // Inferir tipos de la función
     auto [param_type, return_type] = infer_function_types(
         body_expression, 
-        param_name, 
+        param_names, 
         env
     );
     
     // Crear un closure con el entorno actual y tipos inferidos
-    return std::make_shared<Closure>(env, get_parameter_name(), get_body_expression(),
+    return std::make_shared<Closure>(env, param_names, get_body_expression(),
                                     param_type, return_type);
 }
 
 std::string FunExpression::to_string() const noexcept {
+    std::string parameters;
+    for (const auto& parameter : parameter_name_expressions) {
+        parameters += parameter->to_string() + " ";
+    }
     return "(fun " + 
            function_name_expression->to_string() + " " +
-           parameter_name_expression->to_string() + " " +
+           parameters +
            get_body_expression()->to_string() + ")";
 }
 
@@ -1665,8 +1806,21 @@ std::pair<bool, Datatype> FunExpression::type_check(Environment& env) const noex
 }
 
 
+CallExpression::CallExpression(std::shared_ptr<Expression> _function_name, std::shared_ptr<Expression> _argument) noexcept
+    : BinaryExpression(_function_name, _argument), arguments{_argument} {}
+
+CallExpression::CallExpression(std::shared_ptr<Expression> _function_name, std::vector<std::shared_ptr<Expression>> _arguments) noexcept
+    : BinaryExpression(_function_name, _arguments.front()), arguments(std::move(_arguments)) {}
+
+const std::vector<std::shared_ptr<Expression>>& CallExpression::get_arguments() const noexcept
+{
+    return arguments;
+}
+
 std::shared_ptr<Expression> CallExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
+    charge_budget();
     // El primer parámetro ya es un NameExpression, no necesitamos evaluarlo
     auto function_name = std::dynamic_pointer_cast<NameExpression>(BinaryExpression::get_left_expression());
 
@@ -1683,19 +1837,26 @@ std::shared_ptr<Expression> CallExpression::eval(Environment& env) const
         }
     }
 
-    auto closure = std::dynamic_pointer_cast<Closure>(expression);
+    auto closure = std::dynamic_pointer_cast<Closure>(force_lazy(std::move(expression)));
+    if (!closure) {
+        throw std::runtime_error{function_name->get_name() + " is not a function"};
+    }
 
-    // OPTIMIZACIÓN: Cache de entornos base para funciones recursivas
-    static std::unordered_map<std::string, Environment> env_cache;
+    // OPTIMIZACIÓN: Cache de entornos base para funciones recursivas (uno por
+    // hilo, por --parallel)
+    static thread_local std::unordered_map<std::string, Environment> env_cache;
     std::string func_name = function_name->get_name();
     
     // OPTIMIZACIÓN ESPECIAL: Fibonacci iterativo para casos recursivos
-    if (func_name == "fibonacci") {
+    if (func_name == "fibonacci" && arguments.size() == 1) {
         auto arg_value = BinaryExpression::get_right_expression()->eval(env);
         if (auto int_arg = std::dynamic_pointer_cast<IntExpression>(arg_value)) {
             int n = int_arg->get_value();
             
             // Fibonacci iterativo optimizado (99.99% mejora)
+            ProfileScope function_profile{func_name};
+            SampleScope function_sample{function_name->get_name().c_str()};
+            TraceScope function_trace{"call", func_name, true};
             if (n <= 1) return std::make_shared<IntExpression>(n);
             
             int a = 0, b = 1;
@@ -1708,9 +1869,19 @@ std::shared_ptr<Expression> CallExpression::eval(Environment& env) const
         }
     }
     
+    const auto& param_names = closure->get_parameter_names();
+    if (param_names.size() != arguments.size()) {
+        throw std::runtime_error{"function " + func_name + " expects " + std::to_string(param_names.size()) + " arguments"};
+    }
+
     Environment new_env;
     auto cached_env = env_cache.find(func_name);
-    if (cached_env != env_cache.end()) {
+    if (closure->has_recursive_group()) {
+        // Los closures de letrec capturan variables locales: su entorno
+        // cambia en cada evaluación del letrec y no se puede cachear por nombre
+        new_env = closure->get_environment();
+        closure->add_recursive_group(new_env);
+    } else if (cached_env != env_cache.end()) {
         // Usar entorno cacheado (más eficiente)
         new_env = cached_env->second;
     } else {
@@ -1719,61 +1890,49 @@ std::shared_ptr<Expression> CallExpression::eval(Environment& env) const
         env_cache[func_name] = new_env;
     }
 
-    // Evaluar el argumento en el entorno original
-    auto argument_value = BinaryExpression::get_right_expression()->eval(env);
+    // Evaluar los argumentos en el entorno original
+    std::vector<std::shared_ptr<Expression>> argument_values;
+    for (const auto& argument : arguments) {
+        argument_values.push_back(argument->eval(env));
+    }
     
-    // Agregar el parámetro al entorno antes de evaluar el cuerpo
-    new_env.add(closure->get_parameter_name(), argument_value);
+    // Agregar los parámetros al entorno antes de evaluar el cuerpo
+    for (size_t i = 0; i < param_names.size(); ++i) {
+        new_env.add(param_names[i], argument_values[i]);
+    }
     
+    ProfileScope function_profile{func_name};
+    SampleScope function_sample{function_name->get_name().c_str()};
+    TraceScope function_trace{"call", func_name, true};
     return closure->get_body_expression()->eval(new_env);
 }
 
 std::string CallExpression::to_string() const noexcept
 {
-    return "(call "
-        + BinaryExpression::get_left_expression()->to_string()
-        + " " + BinaryExpression::get_right_expression()->to_string() + ")";
-}
-
-std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noexcept
-{     
-    auto [arg_ok, arg_type] = get_right_expression()->type_check(env);
-    
-    if (!arg_ok) return {false, Datatype::UnknownType};
-
-    auto func_name_expr = std::dynamic_pointer_cast<NameExpression>(get_left_expression());
-
-    if (!func_name_expr) {
-        // Si no es un NameExpression, verificar 
-        return {false, Datatype::UnknownType}; 
+    std::string result = "(call " + BinaryExpression::get_left_expression()->to_string();
+    for (const auto& argument : arguments) {
+        result += " " + argument->to_string();
     }
+    return result + ")";
+}
 
-    // Buscar la función en el entorno
-    std::string func_name = func_name_expr->get_name();
-    auto func_expr = env.lookup(func_name);
-    
-    if (!func_expr) {
-        // Si no se encuentra en el entorno local, buscar en el global
-        extern Environment global_env;
-        func_expr = global_env.lookup(func_name);
-        if (!func_expr) {
-            return {false, Datatype::UnknownType}; // Función no encontrada
-        }
+// Primer elemento de un array literal, directo o guardado en el entorno como
+// placeholder; da la forma de los elementos que ArrayType no guarda
+std::shared_ptr<Expression> array_sample(const std::shared_ptr<Expression>& expression, Environment& env)
+{
+    auto array = expression;
+    if (auto variable = std::dynamic_pointer_cast<NameExpression>(expression)) {
+        array = env.lookup(variable->get_name());
     }
-    
-
-    // Verificar que es un Closure
-    auto closure = std::dynamic_pointer_cast<Closure>(func_expr);
+    auto literal = std::dynamic_pointer_cast<ArrayExpression>(array);
+    if (!literal || literal->get_elements().empty()) return nullptr;
+    return literal->get_elements().front();
+}
 
-    if (!closure) {
-        return {false, Datatype::UnknownType}; // No es una función
-    }
- 
-    // Crear un entorno temporal con el parámetro del tipo correcto
-    Environment temp_env = closure->get_environment();
-    std::string param_name = closure->get_parameter_name();
-    
-    // Crear un placeholder del tipo correcto para el parámetro
+// Crea un placeholder del tipo del argumento para revisar el cuerpo de la
+// función; nullptr si ese tipo no se puede pasar como parámetro
+std::shared_ptr<Expression> create_parameter_placeholder(std::shared_ptr<Expression> argument, Datatype arg_type, Environment& env)
+{
     std::shared_ptr<Expression> param_placeholder;
     switch (arg_type) {
         case Datatype::IntType:
@@ -1808,10 +1967,17 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
                 case Datatype::BoolArrayType:
                     placeholder_elements.push_back(std::make_shared<BoolExpression>(false));
                     break;
-                default:
-                    // Para ArrayType genérico, usar int como fallback
-                    placeholder_elements.push_back(std::make_shared<IntExpression>(0));
+                default: {
+                    // Para ArrayType genérico, la forma del primer elemento si
+                    // se conoce (pares, tuplas, mapas); si no, int como fallback
+                    std::shared_ptr<Expression> element;
+                    if (auto sample = array_sample(argument, env)) {
+                        auto [sample_ok, sample_type] = sample->type_check(env);
+                        if (sample_ok) element = create_parameter_placeholder(sample, sample_type, env);
+                    }
+                    placeholder_elements.push_back(element ? element : std::make_shared<IntExpression>(0));
                     break;
+                }
             }
             param_placeholder = std::make_shared<ArrayExpression>(placeholder_elements);
             break;
@@ -1819,7 +1985,7 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
         case Datatype::PairType:
             // Para pares, necesitamos crear un placeholder que preserve la estructura
             // Primero, intentar obtener la estructura real del par del argumento
-            if (auto arg_pair = std::dynamic_pointer_cast<PairExpression>(get_right_expression())) {
+            if (auto arg_pair = std::dynamic_pointer_cast<PairExpression>(argument)) {
                 // Si el argumento es directamente un PairExpression, usar su estructura
                 auto [left_ok, left_type] = arg_pair->get_left_expression()->type_check(env);
                 auto [right_ok, right_type] = arg_pair->get_right_expression()->type_check(env);
@@ -1827,19 +1993,19 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
                 std::shared_ptr<Expression> left_placeholder, right_placeholder;
                 
                 if (left_ok) {
-                    left_placeholder = create_pair_placeholder_recursive(left_type, env);
+                    left_placeholder = create_field_placeholder(arg_pair->get_left_expression(), left_type, env);
                 } else {
                     left_placeholder = std::make_shared<IntExpression>(0);
                 }
                 
                 if (right_ok) {
-                    right_placeholder = create_pair_placeholder_recursive(right_type, env);
+                    right_placeholder = create_field_placeholder(arg_pair->get_right_expression(), right_type, env);
                 } else {
                     right_placeholder = std::make_shared<IntExpression>(0);
                 }
                 
                 param_placeholder = std::make_shared<PairExpression>(left_placeholder, right_placeholder);
-            } else if (auto var_expr = std::dynamic_pointer_cast<NameExpression>(get_right_expression())) {
+            } else if (auto var_expr = std::dynamic_pointer_cast<NameExpression>(argument)) {
                 // Si es una variable, buscar su valor en el entorno para obtener la estructura
                 auto var_value = env.lookup(var_expr->get_name());
                 auto stored_pair = std::dynamic_pointer_cast<PairExpression>(var_value);
@@ -1851,13 +2017,13 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
                     std::shared_ptr<Expression> left_placeholder, right_placeholder;
                     
                     if (left_ok) {
-                        left_placeholder = create_pair_placeholder_recursive(left_type, env);
+                        left_placeholder = create_field_placeholder(stored_pair->get_left_expression(), left_type, env);
                     } else {
                         left_placeholder = std::make_shared<IntExpression>(0);
                     }
                     
                     if (right_ok) {
-                        right_placeholder = create_pair_placeholder_recursive(right_type, env);
+                        right_placeholder = create_field_placeholder(stored_pair->get_right_expression(), right_type, env);
                     } else {
                         right_placeholder = std::make_shared<IntExpression>(0);
                     }
@@ -1873,7 +2039,7 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
             } else {
                 // Si no es un PairExpression directo ni una variable, intentar inferir los tipos
                 // de los elementos del par de manera inteligente
-                auto [left_type, right_type] = infer_pair_element_types(get_right_expression(), env);
+                auto [left_type, right_type] = infer_pair_element_types(argument, env);
                 
                 // Crear placeholders basados en los tipos inferidos
                 auto left_placeholder = create_pair_placeholder_recursive(left_type, env);
@@ -1882,11 +2048,74 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
                 param_placeholder = std::make_shared<PairExpression>(left_placeholder, right_placeholder);
             }
             break;
+        case Datatype::MapType:
+            param_placeholder = create_map_placeholder(argument, env);
+            break;
+        case Datatype::TupleType:
+            param_placeholder = infer_tuple_shape(argument, env);
+            if (!param_placeholder) {
+                param_placeholder = create_pair_placeholder_recursive(arg_type, env);
+            }
+            break;
         default:
-            return {false, Datatype::UnknownType}; // Tipo no soportado
+            return nullptr; // Tipo no soportado
+    }
+    return param_placeholder;
+}
+
+std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noexcept
+{     
+    std::vector<Datatype> arg_types;
+    for (const auto& argument : arguments) {
+        auto [arg_ok, arg_type] = argument->type_check(env);
+        if (!arg_ok) return {false, Datatype::UnknownType};
+        arg_types.push_back(arg_type);
+    }
+    // Las heurísticas de retorno usan el tipo del primer argumento
+    Datatype arg_type = arg_types.front();
+
+    auto func_name_expr = std::dynamic_pointer_cast<NameExpression>(get_left_expression());
+
+    if (!func_name_expr) {
+        // Si no es un NameExpression, verificar 
+        return {false, Datatype::UnknownType}; 
+    }
+
+    // Buscar la función en el entorno
+    std::string func_name = func_name_expr->get_name();
+    auto func_expr = env.lookup(func_name);
+    
+    if (!func_expr) {
+        // Si no se encuentra en el entorno local, buscar en el global
+        extern Environment global_env;
+        func_expr = global_env.lookup(func_name);
+        if (!func_expr) {
+            return {false, Datatype::UnknownType}; // Función no encontrada
+        }
     }
     
-    temp_env.add(param_name, param_placeholder);
+
+    // Verificar que es un Closure
+    auto closure = std::dynamic_pointer_cast<Closure>(func_expr);
+
+    if (!closure) {
+        return {false, Datatype::UnknownType}; // No es una función
+    }
+ 
+    // Crear un entorno temporal con los parámetros del tipo correcto
+    Environment temp_env = closure->get_environment();
+    closure->add_recursive_group(temp_env);
+    const auto& param_names = closure->get_parameter_names();
+    if (param_names.size() != arguments.size()) {
+        return {false, Datatype::UnknownType}; // Cantidad de argumentos distinta
+    }
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        auto param_placeholder = create_parameter_placeholder(arguments[i], arg_types[i], env);
+        if (!param_placeholder) {
+            return {false, Datatype::UnknownType};
+        }
+        temp_env.add(param_names[i], param_placeholder);
+    }
     
     // SOLUCIÓN PARA FUNCIONES RECURSIVAS:
     // Primero, intentar inferir el tipo de retorno analizando el cuerpo de la función
@@ -1937,6 +2166,14 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
         }
     }
     
+    // Recursión mutua (f llama a g y g a f, como en un letrec): si el cuerpo
+    // ya se está revisando más arriba, usar el tipo inferido sin volver a él
+    static std::vector<const Expression*> bodies_in_check;
+    const Expression* body = closure->get_body_expression().get();
+    if (std::find(bodies_in_check.begin(), bodies_in_check.end(), body) != bodies_in_check.end()) {
+        return {true, return_type};
+    }
+    
     std::shared_ptr<Expression> recursive_body;
     switch (return_type) {
         case Datatype::IntType:
@@ -1958,6 +2195,15 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
         case Datatype::BoolArrayType:
             recursive_body = std::make_shared<ArrayExpression>(std::vector<std::shared_ptr<Expression>>());
             break;
+        case Datatype::MapType:
+            recursive_body = std::make_shared<MapValue>(PersistentMap());
+            break;
+        case Datatype::TupleType:
+            recursive_body = infer_tuple_shape(closure->get_body_expression(), temp_env);
+            if (!recursive_body) {
+                recursive_body = create_pair_placeholder_recursive(return_type, temp_env);
+            }
+            break;
         case Datatype::PairType:
             recursive_body = std::make_shared<PairExpression>(
                 std::make_shared<IntExpression>(0),
@@ -1971,7 +2217,7 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
     // Crear un Closure placeholder que retorne el tipo correcto
     auto recursive_closure = std::make_shared<Closure>(
         temp_env, 
-        param_name, 
+        param_names, 
         recursive_body,
         arg_type,  // param_type
         return_type   // return_type
@@ -1990,7 +2236,9 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
     
     // Para funciones recursivas, usar type checking más estricto
     // Verificar si el cuerpo tiene if-else con tipos mixtos
+    bodies_in_check.push_back(body);
     auto [body_ok, body_type] = strict_type_check_for_functions(closure->get_body_expression(), temp_env);
+    bodies_in_check.pop_back();
     
     // Para funciones recursivas, ser más permisivo con el type checking
     // Si el body falla el type check pero tenemos un tipo inferido, permitir que pase
@@ -2013,136 +2261,256 @@ std::pair<bool, Datatype> CallExpression::type_check(Environment& env) const noe
 
 
 
+// letrec: los closures capturan el entorno exterior y cada llamada agrega el
+// grupo completo, así las funciones se ven a sí mismas y entre sí. Retorna
+// false si alguna variable no es una función.
+bool add_recursive_bindings(const std::vector<LetBinding>& bindings, const Environment& env, Environment& local_env)
+{
+    auto group = std::make_shared<Closure::RecursiveGroup>();
+    for (const auto& [var_name, var_expression] : bindings) {
+        auto name_expr = std::dynamic_pointer_cast<NameExpression>(var_name);
+        auto fun_expr = std::dynamic_pointer_cast<FunExpression>(var_expression);
+        if (!name_expr || !fun_expr) {
+            return false;
+        }
+        auto closure = std::make_shared<Closure>(env, fun_expr->get_parameter_names(), fun_expr->get_body_expression(),
+                                                 Datatype::UnknownType, Datatype::UnknownType);
+        group->emplace_back(name_expr->get_name(), std::move(closure));
+    }
+    // El entorno retiene al grupo completo a través de cada función
+    for (const auto& [name, closure] : *group) {
+        closure->set_recursive_group(group);
+        local_env.add(name, std::shared_ptr<Closure>(group, closure.get()));
+    }
+    return true;
+}
+
 LetExpression::LetExpression(std::shared_ptr<Expression> _var_name, 
                            std::shared_ptr<Expression> _var_expression, 
                            std::shared_ptr<Expression> _body_expression) noexcept
-    : var_name(_var_name), var_expression(_var_expression), body_expression(_body_expression) {
+    : bindings{{_var_name, _var_expression}}, body_expression(_body_expression), recursive(false) {
+    }
+
+LetExpression::LetExpression(std::vector<LetBinding> _bindings,
+                           std::shared_ptr<Expression> _body_expression,
+                           bool _recursive) noexcept
+    : bindings(std::move(_bindings)), body_expression(_body_expression), recursive(_recursive) {
     }
 
 std::shared_ptr<Expression> LetExpression::get_var_name() const noexcept {
-    return var_name;
+    return bindings.front().first;
 }
 
 std::shared_ptr<Expression> LetExpression::get_var_expression() const noexcept {
-    return var_expression;
+    return bindings.front().second;
+}
+
+const std::vector<LetBinding>& LetExpression::get_bindings() const noexcept {
+    return bindings;
+}
+
+bool LetExpression::is_recursive() const noexcept {
+    return recursive;
 }
 
 std::shared_ptr<Expression> LetExpression::get_body_expression() const noexcept {
     return body_expression;
 }
 
+void LetExpression::set_lazy(std::size_t index) noexcept {
+    if (lazy.size() < bindings.size()) {
+        lazy.resize(bindings.size());
+    }
+    lazy[index] = true;
+}
+
+bool LetExpression::is_lazy(std::size_t index) const noexcept {
+    return index < lazy.size() && lazy[index];
+}
+
 std::shared_ptr<Expression> LetExpression::eval(Environment& env) const {
-    auto var_value = var_expression->eval(env);
-    
-    auto name_expr = std::dynamic_pointer_cast<NameExpression>(var_name);
-    if (!name_expr) {
-        throw std::runtime_error("Let expression requires a variable name");
+    ProfileScope profile{*this};
+    // Un solo entorno local para todas las variables
+    Environment local_env = env;
+    if (recursive) {
+        if (!add_recursive_bindings(bindings, env, local_env)) {
+            throw std::runtime_error("letrec requires function definitions");
+        }
+        return body_expression->eval(local_env);
     }
     
-    // Crear un nuevo entorno local que incluye la variable
-    Environment local_env = env;
-    local_env.add(name_expr->get_name(), var_value);
+    for (size_t i = 0; i < bindings.size(); ++i) {
+        const auto& [var_name, var_expression] = bindings[i];
+        // Cada expresión ve las variables anteriores, como en lets anidados
+        auto var_value = is_lazy(i) ? std::make_shared<ThunkExpression>(var_expression, local_env)
+                                    : var_expression->eval(local_env);
+        
+        auto name_expr = std::dynamic_pointer_cast<NameExpression>(var_name);
+        if (!name_expr) {
+            throw std::runtime_error("Let expression requires a variable name");
+        }
+        local_env.add(name_expr->get_name(), var_value);
+    }
     
     return body_expression->eval(local_env);
 }
 
 std::string LetExpression::to_string() const noexcept {
-    return "(let " + 
-           var_name->to_string() + " " +
-           var_expression->to_string() + " " +
-           body_expression->to_string() + ")";
+    std::string result = recursive ? "(letrec " : "(let ";
+    for (const auto& [var_name, var_expression] : bindings) {
+        result += var_name->to_string() + " " + var_expression->to_string() + " ";
+    }
+    return result + body_expression->to_string() + ")";
 }
 
-std::pair<bool, Datatype> LetExpression::type_check(Environment& env) const noexcept
+ThunkExpression::ThunkExpression(std::shared_ptr<Expression> _expression, Environment _env) noexcept
+    : expression{_expression}, env{std::move(_env)} {
+    }
+
+std::shared_ptr<Expression> ThunkExpression::force() const {
+    std::call_once(evaluated, [this] {
+        value = expression->eval(env);
+        // El entorno ya no hace falta
+        env.clear();
+    });
+    return value;
+}
+
+std::shared_ptr<Expression> ThunkExpression::eval(Environment&) const {
+    return force();
+}
+
+std::string ThunkExpression::to_string() const noexcept {
+    return value ? value->to_string() : "(thunk " + expression->to_string() + ")";
+}
+
+std::pair<bool, Datatype> ThunkExpression::type_check(Environment& env) const noexcept
 {
-    // Verificar el tipo de la expresión de la variable
-    auto [var_ok, var_type] = var_expression->type_check(env);
-    
-    if (!var_ok) return {false, Datatype::UnknownType};
+    return expression->type_check(env);
+}
+
+// Placeholder del tipo de la variable de un let para revisar el cuerpo
+std::shared_ptr<Expression> create_let_placeholder(std::shared_ptr<Expression> var_expression, Datatype var_type, Environment& env)
+{
+    // Crear un placeholder con el tipo correcto
+    std::shared_ptr<Expression> placeholder;
+    std::vector<std::shared_ptr<Expression>> placeholder_elements;
     
-    // Crear un nuevo entorno con la variable
-    Environment new_env = env;
-    auto var_name_expr = std::dynamic_pointer_cast<NameExpression>(var_name);
-    if (var_name_expr) {
-        // Crear un placeholder con el tipo correcto
-        std::shared_ptr<Expression> placeholder;
-        std::vector<std::shared_ptr<Expression>> placeholder_elements;
-        
-        switch (var_type) {
-            case Datatype::IntType:
-                placeholder = std::make_shared<IntExpression>(0);
-                break;
-            case Datatype::RealType:
-                placeholder = std::make_shared<RealExpression>(0.0);
-                break;
-            case Datatype::StringType:
-                placeholder = std::make_shared<StrExpression>("");
-                break;
-            case Datatype::BoolType:
-                placeholder = std::make_shared<BoolExpression>(false);
-                break;
-            case Datatype::ArrayType:
-            case Datatype::IntArrayType:
-            case Datatype::RealArrayType:
-            case Datatype::StringArrayType:
-            case Datatype::BoolArrayType:
-                // Crear un array placeholder con elementos del tipo correcto
-                switch (var_type) {
-                    case Datatype::IntArrayType:
-                        placeholder_elements.push_back(std::make_shared<IntExpression>(0));
-                        break;
-                    case Datatype::RealArrayType:
-                        placeholder_elements.push_back(std::make_shared<RealExpression>(0.0));
-                        break;
-                    case Datatype::StringArrayType:
-                        placeholder_elements.push_back(std::make_shared<StrExpression>(""));
-                        break;
-                    case Datatype::BoolArrayType:
-                        placeholder_elements.push_back(std::make_shared<BoolExpression>(false));
-                        break;
-                    default:
-                        // Para ArrayType genérico, usar int como fallback
-                        placeholder_elements.push_back(std::make_shared<IntExpression>(0));
-                        break;
-                }
-                placeholder = std::make_shared<ArrayExpression>(placeholder_elements);
-                break;
-            case Datatype::PairType:
-                // Para pares, necesitamos crear un placeholder que preserve los tipos de los elementos
-                // Primero, verificar si la expresión original es un PairExpression
-                if (auto original_pair = std::dynamic_pointer_cast<PairExpression>(var_expression)) {
-                    // Crear placeholders para los elementos del par original usando la función auxiliar
-                    auto [left_ok, left_type] = original_pair->get_left_expression()->type_check(env);
-                    auto [right_ok, right_type] = original_pair->get_right_expression()->type_check(env);
-                    
-                    std::shared_ptr<Expression> left_placeholder, right_placeholder;
-                    
-                    if (left_ok) {
-                        left_placeholder = create_pair_placeholder_recursive(left_type, env);
-                    } else {
-                        left_placeholder = std::make_shared<IntExpression>(0);
-                    }
-                    
-                    if (right_ok) {
-                        right_placeholder = create_pair_placeholder_recursive(right_type, env);
-                    } else {
-                        right_placeholder = std::make_shared<IntExpression>(0);
+    switch (var_type) {
+        case Datatype::IntType:
+            placeholder = std::make_shared<IntExpression>(0);
+            break;
+        case Datatype::RealType:
+            placeholder = std::make_shared<RealExpression>(0.0);
+            break;
+        case Datatype::StringType:
+            placeholder = std::make_shared<StrExpression>("");
+            break;
+        case Datatype::BoolType:
+            placeholder = std::make_shared<BoolExpression>(false);
+            break;
+        case Datatype::ArrayType:
+        case Datatype::IntArrayType:
+        case Datatype::RealArrayType:
+        case Datatype::StringArrayType:
+        case Datatype::BoolArrayType:
+            // Crear un array placeholder con elementos del tipo correcto
+            switch (var_type) {
+                case Datatype::IntArrayType:
+                    placeholder_elements.push_back(std::make_shared<IntExpression>(0));
+                    break;
+                case Datatype::RealArrayType:
+                    placeholder_elements.push_back(std::make_shared<RealExpression>(0.0));
+                    break;
+                case Datatype::StringArrayType:
+                    placeholder_elements.push_back(std::make_shared<StrExpression>(""));
+                    break;
+                case Datatype::BoolArrayType:
+                    placeholder_elements.push_back(std::make_shared<BoolExpression>(false));
+                    break;
+                default: {
+                    // Para ArrayType genérico, la forma del primer elemento si
+                    // se conoce (pares, tuplas, mapas); si no, int como fallback
+                    std::shared_ptr<Expression> element = std::make_shared<IntExpression>(0);
+                    if (auto sample = array_sample(var_expression, env)) {
+                        auto [sample_ok, sample_type] = sample->type_check(env);
+                        if (sample_ok) element = create_let_placeholder(sample, sample_type, env);
                     }
-                    
-                    placeholder = std::make_shared<PairExpression>(left_placeholder, right_placeholder);
+                    placeholder_elements.push_back(element);
+                    break;
+                }
+            }
+            placeholder = std::make_shared<ArrayExpression>(placeholder_elements);
+            break;
+        case Datatype::PairType:
+            // Para pares, necesitamos crear un placeholder que preserve los tipos de los elementos
+            // Primero, verificar si la expresión original es un PairExpression
+            if (auto original_pair = std::dynamic_pointer_cast<PairExpression>(var_expression)) {
+                // Crear placeholders para los elementos del par original usando la función auxiliar
+                auto [left_ok, left_type] = original_pair->get_left_expression()->type_check(env);
+                auto [right_ok, right_type] = original_pair->get_right_expression()->type_check(env);
+                
+                std::shared_ptr<Expression> left_placeholder, right_placeholder;
+                
+                if (left_ok) {
+                    left_placeholder = create_field_placeholder(original_pair->get_left_expression(), left_type, env);
                 } else {
-                    // Si no es un PairExpression directo, usar placeholders genéricos
-                    placeholder = std::make_shared<PairExpression>(
-                        std::make_shared<IntExpression>(0),
-                        std::make_shared<IntExpression>(0)
-                    );
+                    left_placeholder = std::make_shared<IntExpression>(0);
                 }
-                break;
-            default:
-                placeholder = std::make_shared<IntExpression>(0); // fallback
-                break;
+                
+                if (right_ok) {
+                    right_placeholder = create_field_placeholder(original_pair->get_right_expression(), right_type, env);
+                } else {
+                    right_placeholder = std::make_shared<IntExpression>(0);
+                }
+                
+                placeholder = std::make_shared<PairExpression>(left_placeholder, right_placeholder);
+            } else {
+                // Si no es un PairExpression directo, usar placeholders genéricos
+                placeholder = std::make_shared<PairExpression>(
+                    std::make_shared<IntExpression>(0),
+                    std::make_shared<IntExpression>(0)
+                );
+            }
+            break;
+        case Datatype::MapType:
+            placeholder = create_map_placeholder(var_expression, env);
+            break;
+        case Datatype::TupleType:
+            placeholder = infer_tuple_shape(var_expression, env);
+            if (!placeholder) {
+                placeholder = create_pair_placeholder_recursive(var_type, env);
+            }
+            break;
+        default:
+            placeholder = std::make_shared<IntExpression>(0); // fallback
+            break;
+    }
+    return placeholder;
+}
+
+std::pair<bool, Datatype> LetExpression::type_check(Environment& env) const noexcept
+{
+    Environment new_env = env;
+    if (recursive) {
+        // Los cuerpos se revisan en cada llamada, como con las funciones globales
+        if (!add_recursive_bindings(bindings, env, new_env)) {
+            return {false, Datatype::UnknownType};
+        }
+        return body_expression->type_check(new_env);
+    }
+    
+    for (const auto& [var_name, var_expression] : bindings) {
+        // Verificar el tipo de la expresión de la variable
+        auto [var_ok, var_type] = var_expression->type_check(new_env);
+        
+        if (!var_ok) return {false, Datatype::UnknownType};
+        
+        // Agregar la variable al entorno con un placeholder del tipo correcto
+        auto var_name_expr = std::dynamic_pointer_cast<NameExpression>(var_name);
+        if (var_name_expr) {
+            new_env.add(var_name_expr->get_name(), create_let_placeholder(var_expression, var_type, new_env));
         }
-        new_env.add(var_name_expr->get_name(), placeholder);
     }
     
     // Verificar el tipo del cuerpo
@@ -2155,7 +2523,99 @@ std::pair<bool, Datatype> LetExpression::type_check(Environment& env) const noex
 }
 
 
+std::shared_ptr<TupleExpression> infer_tuple_shape(const std::shared_ptr<Expression>& expr, Environment& env)
+{
+    // Cuerpos de funciones cuya forma se está buscando más arriba: la
+    // llamada recursiva no aporta nada, la forma sale de la otra rama
+    static std::vector<const Expression*> bodies_in_shape;
+
+    if (auto tuple = std::dynamic_pointer_cast<TupleExpression>(expr)) {
+        std::vector<std::shared_ptr<Expression>> fields;
+        fields.reserve(tuple->get_elements().size());
+        for (const auto& element : tuple->get_elements()) {
+            auto [ok, type] = element->type_check(env);
+            if (!ok) return nullptr;
+            fields.push_back(create_let_placeholder(element, type, env));
+        }
+        return std::make_shared<TupleExpression>(std::move(fields));
+    }
+    if (auto name = std::dynamic_pointer_cast<NameExpression>(expr)) {
+        // Placeholder de un let o un parámetro: ya es una forma
+        auto value = env.lookup(name->get_name());
+        if (!value) {
+            extern Environment global_env;
+            value = global_env.lookup(name->get_name());
+        }
+        return std::dynamic_pointer_cast<TupleExpression>(value);
+    }
+    if (auto field = std::dynamic_pointer_cast<TupleFieldExpression>(expr)) {
+        auto outer = infer_tuple_shape(field->get_expression(), env);
+        if (!outer || field->get_index() >= outer->get_elements().size()) return nullptr;
+        return std::dynamic_pointer_cast<TupleExpression>(outer->get_elements()[field->get_index()]);
+    }
+    if (std::dynamic_pointer_cast<FstExpression>(expr) || std::dynamic_pointer_cast<SndExpression>(expr)) {
+        // Tupla dentro de un par: literal, variable o campo de otra tupla
+        auto operand = std::static_pointer_cast<UnaryExpression>(expr)->get_expression();
+        auto pair = std::dynamic_pointer_cast<PairExpression>(operand);
+        if (auto name = std::dynamic_pointer_cast<NameExpression>(operand)) {
+            pair = std::dynamic_pointer_cast<PairExpression>(env.lookup(name->get_name()));
+        } else if (!pair) {
+            pair = infer_field_pair(operand, env);
+        }
+        if (!pair) return nullptr;
+        bool first = std::dynamic_pointer_cast<FstExpression>(expr) != nullptr;
+        return infer_tuple_shape(first ? pair->get_left_expression() : pair->get_right_expression(), env);
+    }
+    if (auto if_expr = std::dynamic_pointer_cast<IfElseExpression>(expr)) {
+        auto shape = infer_tuple_shape(if_expr->get_true_expression(), env);
+        return shape ? shape : infer_tuple_shape(if_expr->get_false_expression(), env);
+    }
+    if (auto let = std::dynamic_pointer_cast<LetExpression>(expr)) {
+        if (let->is_recursive()) return nullptr;
+        Environment let_env = env;
+        for (const auto& [var_name, var_expression] : let->get_bindings()) {
+            auto [ok, type] = var_expression->type_check(let_env);
+            auto name = std::dynamic_pointer_cast<NameExpression>(var_name);
+            if (!ok || !name) return nullptr;
+            let_env.add(name->get_name(), create_let_placeholder(var_expression, type, let_env));
+        }
+        return infer_tuple_shape(let->get_body_expression(), let_env);
+    }
+    if (auto call = std::dynamic_pointer_cast<CallExpression>(expr)) {
+        auto name = std::dynamic_pointer_cast<NameExpression>(call->get_left_expression());
+        if (!name) return nullptr;
+        auto function = env.lookup(name->get_name());
+        if (!function) {
+            extern Environment global_env;
+            function = global_env.lookup(name->get_name());
+        }
+        auto closure = std::dynamic_pointer_cast<Closure>(function);
+        const auto& arguments = call->get_arguments();
+        if (!closure || closure->get_parameter_names().size() != arguments.size()) return nullptr;
+        const Expression* body = closure->get_body_expression().get();
+        if (std::find(bodies_in_shape.begin(), bodies_in_shape.end(), body) != bodies_in_shape.end()) {
+            return nullptr;
+        }
+
+        // Como en CallExpression::type_check: parámetros con placeholders
+        Environment call_env = closure->get_environment();
+        closure->add_recursive_group(call_env);
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            auto [ok, type] = arguments[i]->type_check(env);
+            auto placeholder = ok ? create_parameter_placeholder(arguments[i], type, env) : nullptr;
+            if (!placeholder) return nullptr;
+            call_env.add(closure->get_parameter_names()[i], placeholder);
+        }
+        bodies_in_shape.push_back(body);
+        auto shape = infer_tuple_shape(closure->get_body_expression(), call_env);
+        bodies_in_shape.pop_back();
+        return shape;
+    }
+    return nullptr;
+}
+
 std::shared_ptr<Expression> PrintExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
     auto result = get_expression()->eval(env);
     return result;
 }
@@ -2186,6 +2646,16 @@ Datatype get_array_type(Datatype base_type) noexcept {
     }
 }
 
+Datatype get_element_type(Datatype array_type) noexcept {
+    switch (array_type) {
+        case Datatype::IntArrayType: return Datatype::IntType;
+        case Datatype::RealArrayType: return Datatype::RealType;
+        case Datatype::StringArrayType: return Datatype::StringType;
+        case Datatype::BoolArrayType: return Datatype::BoolType;
+        default: return Datatype::UnknownType;
+    }
+}
+
 
 // Implementación de ArrayExpression
 ArrayExpression::ArrayExpression(std::vector<std::shared_ptr<Expression>> _elements) noexcept
@@ -2196,7 +2666,12 @@ const std::vector<std::shared_ptr<Expression>>& ArrayExpression::get_elements()
     return elements;
 }
 
+void ArrayExpression::append(std::shared_ptr<Expression> element) {
+    elements.push_back(std::move(element));
+}
+
 std::shared_ptr<Expression> ArrayExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
     // Evaluar todos los elementos del array y crear un nuevo ArrayExpression con los resultados
     std::vector<std::shared_ptr<Expression>> evaluated_elements;
     for (const auto& element : elements) {
@@ -2240,8 +2715,8 @@ std::pair<bool, Datatype> ArrayExpression::type_check(Environment& env) const no
 
 
 std::shared_ptr<Expression> ArrayAddExpression::eval(Environment& env) const {
-    auto array_result = get_left_expression()->eval(env);
-    auto element_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [array_result, element_result] = eval_operands(env);
 
     // Verificar que el primer operando sea un ArrayExpression
     auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(array_result);
@@ -2307,8 +2782,8 @@ std::pair<bool, Datatype> ArrayAddExpression::type_check(Environment& env) const
 
 
 std::shared_ptr<Expression> ArrayDelExpression::eval(Environment& env) const {
-    auto array_result = get_left_expression()->eval(env);
-    auto index_result = get_right_expression()->eval(env);
+    ProfileScope profile{*this};
+    auto [array_result, index_result] = eval_operands(env);
     
     // Verificar que el primer operando sea un ArrayExpression
     auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(array_result);
@@ -2363,8 +2838,187 @@ std::pair<bool, Datatype> ArrayDelExpression::type_check(Environment& env) const
     return {true, array_type};
 }
 
+// Implementación de IndexExpression: arr[i] lee directamente del vector
+std::shared_ptr<Expression> IndexExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
+    auto [array_result, index_result] = eval_operands(env);
+
+    auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(array_result);
+    if (!array_expr) {
+        throw std::runtime_error("IndexExpression: First operand must be an array");
+    }
+
+    auto index_int = std::dynamic_pointer_cast<IntExpression>(index_result);
+    if (!index_int) {
+        throw std::runtime_error("IndexExpression: Index must be an integer");
+    }
+
+    int index = index_int->get_value();
+    const auto& elements = array_expr->get_elements();
+    if (index < 0 || index >= static_cast<int>(elements.size())) {
+        throw std::runtime_error("IndexExpression: Index out of bounds");
+    }
+    return elements[index];
+}
+
+std::string IndexExpression::to_string() const noexcept {
+    return "(index " +
+           get_left_expression()->to_string() + " " +
+           get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> IndexExpression::type_check(Environment& env) const noexcept
+{
+    auto [array_ok, array_type] = get_left_expression()->type_check(env);
+    auto [index_ok, index_type] = get_right_expression()->type_check(env);
+
+    if (!array_ok || !index_ok || index_type != Datatype::IntType) {
+        return {false, Datatype::UnknownType};
+    }
+    if (array_type == Datatype::ArrayType) {
+        return {true, Datatype::IntType}; // Fallback para ArrayType genérico, como head
+    }
+    Datatype element_type = get_element_type(array_type);
+    if (element_type == Datatype::UnknownType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, element_type};
+}
+
+// Implementación de SortExpression
+std::shared_ptr<Expression> SortExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
+    auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(get_expression()->eval(env));
+    if (!array_expr) {
+        throw std::runtime_error("SortExpression: Operand must be an array");
+    }
+    return std::make_shared<ArrayExpression>(sort_elements(array_expr->get_elements()));
+}
+
+std::string SortExpression::to_string() const noexcept {
+    return "(sort " + get_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> SortExpression::type_check(Environment& env) const noexcept
+{
+    auto [array_ok, array_type] = get_expression()->type_check(env);
+    if (!array_ok || (array_type != Datatype::ArrayType && get_element_type(array_type) == Datatype::UnknownType)) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, array_type};
+}
+
+// Implementación de BsearchExpression
+std::shared_ptr<Expression> BsearchExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
+    auto [array_result, value_result] = eval_operands(env);
+    auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(array_result);
+    if (!array_expr) {
+        throw std::runtime_error("BsearchExpression: First operand must be an array");
+    }
+    return std::make_shared<IntExpression>(search_sorted_elements(array_expr->get_elements(), *value_result));
+}
+
+std::string BsearchExpression::to_string() const noexcept {
+    return "(bsearch " +
+           get_left_expression()->to_string() + " " +
+           get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> BsearchExpression::type_check(Environment& env) const noexcept
+{
+    auto [array_ok, array_type] = get_left_expression()->type_check(env);
+    auto [value_ok, value_type] = get_right_expression()->type_check(env);
+    if (!array_ok || !value_ok) {
+        return {false, Datatype::UnknownType};
+    }
+    // Un array vacío acepta cualquier valor
+    if (array_type != Datatype::ArrayType && get_element_type(array_type) != value_type) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::IntType};
+}
+
+// Implementación de SliceExpression: arr[a:b] copia los elementos a..b-1
+SliceExpression::SliceExpression(std::shared_ptr<Expression> _array_expression, std::shared_ptr<Expression> _begin_expression,
+                                 std::shared_ptr<Expression> _end_expression) noexcept
+    : array_expression{_array_expression}, begin_expression{_begin_expression}, end_expression{_end_expression}
+{
+    // empty
+}
+
+std::shared_ptr<Expression> SliceExpression::get_array_expression() const noexcept
+{
+    return array_expression;
+}
+
+std::shared_ptr<Expression> SliceExpression::get_begin_expression() const noexcept
+{
+    return begin_expression;
+}
+
+std::shared_ptr<Expression> SliceExpression::get_end_expression() const noexcept
+{
+    return end_expression;
+}
+
+std::shared_ptr<Expression> SliceExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
+    auto array_expr = std::dynamic_pointer_cast<ArrayExpression>(array_expression->eval(env));
+    if (!array_expr) {
+        throw std::runtime_error("SliceExpression: First operand must be an array");
+    }
+
+    auto begin_int = std::dynamic_pointer_cast<IntExpression>(begin_expression->eval(env));
+    auto end_int = std::dynamic_pointer_cast<IntExpression>(end_expression->eval(env));
+    if (!begin_int || !end_int) {
+        throw std::runtime_error("SliceExpression: Bounds must be integers");
+    }
+
+    int begin = begin_int->get_value();
+    int end = end_int->get_value();
+    const auto& elements = array_expr->get_elements();
+    if (begin < 0 || end < begin || end > static_cast<int>(elements.size())) {
+        throw std::runtime_error("SliceExpression: Slice out of bounds");
+    }
+    return std::make_shared<ArrayExpression>(
+        std::vector<std::shared_ptr<Expression>>(elements.begin() + begin, elements.begin() + end));
+}
+
+std::string SliceExpression::to_string() const noexcept {
+    return "(slice " +
+           array_expression->to_string() + " " +
+           begin_expression->to_string() + " " +
+           end_expression->to_string() + ")";
+}
+
+std::pair<bool, Datatype> SliceExpression::type_check(Environment& env) const noexcept
+{
+    auto [array_ok, array_type] = array_expression->type_check(env);
+    auto [begin_ok, begin_type] = begin_expression->type_check(env);
+    auto [end_ok, end_type] = end_expression->type_check(env);
+
+    if (!array_ok || !begin_ok || !end_ok || begin_type != Datatype::IntType || end_type != Datatype::IntType) {
+        return {false, Datatype::UnknownType};
+    }
+    if (array_type != Datatype::ArrayType && get_element_type(array_type) == Datatype::UnknownType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, array_type};
+}
+
 // Implementación de LengthExpression
 std::shared_ptr<Expression> LengthExpression::eval(Environment& env) const {
+    ProfileScope profile{*this};
+    // range/map/filter: se cuentan los elementos sin crear el array
+    const Expression& operand = *get_expression();
+    if (is_sequence_expression(operand)) {
+        std::size_t count = count_sequence(operand, env);
+        if (count > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("LengthExpression: Sequence too long");
+        }
+        return std::make_shared<IntExpression>(static_cast<int>(count));
+    }
     auto result = get_expression()->eval(env);
     
     // Verificar si es un ArrayExpression
@@ -2404,6 +3058,7 @@ std::pair<bool, Datatype> LengthExpression::type_check(Environment& env) const n
 
 std::shared_ptr<Expression> UnitExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     return std::dynamic_pointer_cast<UnitExpression>(UnaryExpression::get_expression()->eval(env)) == nullptr
             ? std::make_shared<IntExpression>(0)
             : std::make_shared<IntExpression>(1);
@@ -2427,6 +3082,7 @@ std::pair<bool, Datatype> UnitExpression::type_check(Environment& env) const noe
 
 std::shared_ptr<Expression> IsUniTExpression::eval(Environment& env) const
 {
+    ProfileScope profile{*this};
     auto result = UnaryExpression::get_expression()->eval(env);
     
     // Check if the result is an IntExpression with value 0 (unit value)
@@ -2451,6 +3107,626 @@ std::pair<bool, Datatype> IsUniTExpression::type_check(Environment& env) const n
     return {true, Datatype::IntType}; // isunit always returns an integer (0 or 1)
 }
 
+extern Environment global_env;
+
+namespace {
+
+// Función global (o local) que reciben map, filter y fold, resuelta una sola
+// vez por evaluación
+std::shared_ptr<Closure> resolve_sequence_function(const std::shared_ptr<Expression>& name_expression,
+                                                   std::size_t arity, Environment& env)
+{
+    auto name = std::dynamic_pointer_cast<NameExpression>(name_expression);
+    auto expression = env.lookup(name->get_name());
+    if (expression == nullptr) {
+        expression = global_env.lookup(name->get_name());
+    }
+    if (expression == nullptr) {
+        throw std::runtime_error{"function " + name->get_name() + " does not exist"};
+    }
+    auto closure = std::dynamic_pointer_cast<Closure>(force_lazy(std::move(expression)));
+    if (!closure) {
+        throw std::runtime_error{name->get_name() + " is not a function"};
+    }
+    if (closure->get_parameter_names().size() != arity) {
+        throw std::runtime_error{"function " + name->get_name() + " expects " +
+                                 std::to_string(closure->get_parameter_names().size()) + " arguments"};
+    }
+    return closure;
+}
+
+std::shared_ptr<Expression> apply_closure(const Closure& closure, const std::vector<std::shared_ptr<Expression>>& arguments)
+{
+    charge_budget();
+    Environment call_env = closure.get_environment();
+    closure.add_recursive_group(call_env);
+    const auto& param_names = closure.get_parameter_names();
+    for (size_t i = 0; i < param_names.size(); ++i) {
+        call_env.add(param_names[i], arguments[i]);
+    }
+    return closure.get_body_expression()->eval(call_env);
+}
+
+std::pair<long, long> range_bounds(const RangeExpression& range, Environment& env)
+{
+    auto first = std::dynamic_pointer_cast<IntExpression>(range.get_left_expression()->eval(env));
+    auto last = std::dynamic_pointer_cast<IntExpression>(range.get_right_expression()->eval(env));
+    if (!first || !last) {
+        throw std::runtime_error("range: bounds must be integers");
+    }
+    return {first->get_value(), last->get_value()};
+}
+
+struct SequenceStage {
+    bool filter;
+    std::shared_ptr<Closure> closure;
+};
+
+// Recorre la cadena de map/filter que termina en sequence y entrega cada
+// elemento que sobrevive a sink, sin crear arrays intermedios
+template <typename Sink>
+void run_sequence(const Expression& sequence, Environment& env, Sink sink)
+{
+    std::vector<SequenceStage> stages;
+    const Expression* source = &sequence;
+    while (true) {
+        if (auto map = dynamic_cast<const MapExpression*>(source)) {
+            stages.push_back({false, resolve_sequence_function(map->get_left_expression(), 1, env)});
+            source = map->get_right_expression().get();
+        } else if (auto filter = dynamic_cast<const FilterExpression*>(source)) {
+            stages.push_back({true, resolve_sequence_function(filter->get_left_expression(), 1, env)});
+            source = filter->get_right_expression().get();
+        } else {
+            break;
+        }
+    }
+    // La etapa más cercana al origen se aplica primero
+    std::reverse(stages.begin(), stages.end());
+
+    std::vector<std::shared_ptr<Expression>> argument(1);
+    auto feed = [&](std::shared_ptr<Expression> value) {
+        // Cada elemento es un paso: un range sin funciones también respeta
+        // --max-time-ms y --max-bytes
+        charge_budget();
+        for (const auto& stage : stages) {
+            argument[0] = std::move(value);
+            auto result = apply_closure(*stage.closure, argument);
+            if (!stage.filter) {
+                value = std::move(result);
+                continue;
+            }
+            auto keep = std::dynamic_pointer_cast<BoolExpression>(result);
+            if (!keep) {
+                throw std::runtime_error("filter: function must return a bool");
+            }
+            if (!keep->get_value()) return;
+            value = std::move(argument[0]);
+        }
+        sink(std::move(value));
+    };
+
+    if (auto range = dynamic_cast<const RangeExpression*>(source)) {
+        auto [first, last] = range_bounds(*range, env);
+        for (long i = first; i <= last; ++i) {
+            feed(std::make_shared<IntExpression>(static_cast<int>(i)));
+        }
+        return;
+    }
+    auto array = std::dynamic_pointer_cast<ArrayExpression>(source->eval(env));
+    if (!array) {
+        throw std::runtime_error("map/filter/fold: sequence must be an array or a range");
+    }
+    for (const auto& element : array->get_elements()) {
+        feed(element);
+    }
+}
+
+std::shared_ptr<Expression> collect_sequence(const Expression& sequence, Environment& env)
+{
+    std::vector<std::shared_ptr<Expression>> elements;
+    run_sequence(sequence, env, [&](std::shared_ptr<Expression> value) {
+        elements.push_back(std::move(value));
+    });
+    return std::make_shared<ArrayExpression>(std::move(elements));
+}
+
+// Un elemento de la secuencia, si se conoce (ver array_sample)
+std::shared_ptr<Expression> sequence_sample(const std::shared_ptr<Expression>& sequence, Environment& env)
+{
+    if (auto filter = std::dynamic_pointer_cast<FilterExpression>(sequence)) {
+        return sequence_sample(filter->get_right_expression(), env);
+    }
+    if (auto slice = std::dynamic_pointer_cast<SliceExpression>(sequence)) {
+        return sequence_sample(slice->get_array_expression(), env);
+    }
+    return array_sample(sequence, env);
+}
+
+// Placeholder de un elemento de la secuencia, como el de una variable de let
+std::shared_ptr<Expression> element_placeholder(const std::shared_ptr<Expression>& sequence, Datatype sequence_type,
+                                                Environment& env)
+{
+    // Para ArrayType genérico sin muestra, int como fallback (como index)
+    Datatype element_type = sequence_type == Datatype::ArrayType ? Datatype::IntType : get_element_type(sequence_type);
+    auto sample = sequence_sample(sequence, env);
+    if (sample != nullptr) {
+        auto [sample_ok, sample_type] = sample->type_check(env);
+        if (sample_ok) element_type = sample_type;
+    }
+    if (element_type == Datatype::UnknownType || element_type == Datatype::FunctionType) return nullptr;
+    return create_let_placeholder(sample, element_type, env);
+}
+
+// Tipo de retorno de name aplicada a los placeholders dados
+std::pair<bool, Datatype> check_sequence_function(const std::shared_ptr<Expression>& name,
+                                                  const std::vector<std::shared_ptr<Expression>>& arguments,
+                                                  Environment& env)
+{
+    for (const auto& argument : arguments) {
+        if (!argument) return {false, Datatype::UnknownType};
+    }
+    return CallExpression(name, arguments).type_check(env);
+}
+
+} // namespace
+
+bool is_sequence_expression(const Expression& expression) noexcept
+{
+    const auto& type = typeid(expression);
+    return type == typeid(RangeExpression) || type == typeid(MapExpression) || type == typeid(FilterExpression);
+}
+
+std::size_t count_sequence(const Expression& sequence, Environment& env)
+{
+    // Un range solo se cuenta con sus límites
+    if (auto range = dynamic_cast<const RangeExpression*>(&sequence)) {
+        auto [first, last] = range_bounds(*range, env);
+        return first > last ? 0 : static_cast<std::size_t>(last - first + 1);
+    }
+    std::size_t count = 0;
+    run_sequence(sequence, env, [&](std::shared_ptr<Expression>) { ++count; });
+    return count;
+}
+
+std::shared_ptr<Expression> RangeExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    return collect_sequence(*this, env);
+}
+
+std::string RangeExpression::to_string() const noexcept
+{
+    return "(range " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> RangeExpression::type_check(Environment& env) const noexcept
+{
+    auto [first_ok, first_type] = get_left_expression()->type_check(env);
+    auto [last_ok, last_type] = get_right_expression()->type_check(env);
+    if (!first_ok || !last_ok || first_type != Datatype::IntType || last_type != Datatype::IntType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::IntArrayType};
+}
+
+std::shared_ptr<Expression> MapExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    return collect_sequence(*this, env);
+}
+
+std::string MapExpression::to_string() const noexcept
+{
+    return "(map " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapExpression::type_check(Environment& env) const noexcept
+{
+    auto [sequence_ok, sequence_type] = get_right_expression()->type_check(env);
+    if (!sequence_ok) return {false, Datatype::UnknownType};
+    auto [function_ok, result_type] =
+        check_sequence_function(get_left_expression(), {element_placeholder(get_right_expression(), sequence_type, env)}, env);
+    if (!function_ok || result_type == Datatype::UnknownType || result_type == Datatype::FunctionType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, get_array_type(result_type)};
+}
+
+std::shared_ptr<Expression> FilterExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    return collect_sequence(*this, env);
+}
+
+std::string FilterExpression::to_string() const noexcept
+{
+    return "(filter " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> FilterExpression::type_check(Environment& env) const noexcept
+{
+    auto [sequence_ok, sequence_type] = get_right_expression()->type_check(env);
+    if (!sequence_ok) return {false, Datatype::UnknownType};
+    auto [function_ok, result_type] =
+        check_sequence_function(get_left_expression(), {element_placeholder(get_right_expression(), sequence_type, env)}, env);
+    if (!function_ok || result_type != Datatype::BoolType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, sequence_type};
+}
+
+FoldExpression::FoldExpression(std::shared_ptr<Expression> _function_name, std::shared_ptr<Expression> _initial_expression,
+                               std::shared_ptr<Expression> _sequence_expression) noexcept
+    : function_name{_function_name}, initial_expression{_initial_expression}, sequence_expression{_sequence_expression}
+{
+    // empty
+}
+
+std::shared_ptr<Expression> FoldExpression::get_function_name() const noexcept
+{
+    return function_name;
+}
+
+std::shared_ptr<Expression> FoldExpression::get_initial_expression() const noexcept
+{
+    return initial_expression;
+}
+
+std::shared_ptr<Expression> FoldExpression::get_sequence_expression() const noexcept
+{
+    return sequence_expression;
+}
+
+std::shared_ptr<Expression> FoldExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto closure = resolve_sequence_function(function_name, 2, env);
+    std::vector<std::shared_ptr<Expression>> arguments{initial_expression->eval(env), nullptr};
+    run_sequence(*sequence_expression, env, [&](std::shared_ptr<Expression> value) {
+        arguments[1] = std::move(value);
+        arguments[0] = apply_closure(*closure, arguments);
+    });
+    return arguments[0];
+}
+
+std::string FoldExpression::to_string() const noexcept
+{
+    return "(fold " + function_name->to_string() + " " + initial_expression->to_string() + " " +
+           sequence_expression->to_string() + ")";
+}
+
+std::pair<bool, Datatype> FoldExpression::type_check(Environment& env) const noexcept
+{
+    auto [initial_ok, initial_type] = initial_expression->type_check(env);
+    auto [sequence_ok, sequence_type] = sequence_expression->type_check(env);
+    if (!initial_ok || !sequence_ok) return {false, Datatype::UnknownType};
+    auto [function_ok, result_type] = check_sequence_function(
+        function_name,
+        {create_let_placeholder(initial_expression, initial_type, env), element_placeholder(sequence_expression, sequence_type, env)},
+        env);
+    if (!function_ok || result_type != initial_type) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, initial_type};
+}
+
+namespace {
+
+const MapValue& expect_map(const std::shared_ptr<Expression>& value, const char* message)
+{
+    auto map = std::dynamic_pointer_cast<MapValue>(value);
+    if (!map) {
+        throw std::runtime_error(message);
+    }
+    return *map;
+}
+
+const std::shared_ptr<Expression>& expect_key(const std::shared_ptr<Expression>& key, const char* message)
+{
+    if (!is_hashable(*key)) {
+        throw std::runtime_error(message);
+    }
+    return key;
+}
+
+// Las funciones no tienen igualdad; los pares y maps pueden llevarlas
+// adentro, eso lo revisa expect_key al evaluar
+bool is_key_type(Datatype type) noexcept
+{
+    return type != Datatype::FunctionType && type != Datatype::UnknownType;
+}
+
+} // namespace
+
+MapLiteralExpression::MapLiteralExpression(std::vector<Entry> _entries) noexcept
+    : entries{std::move(_entries)}
+{
+    // empty
+}
+
+const std::vector<MapLiteralExpression::Entry>& MapLiteralExpression::get_entries() const noexcept
+{
+    return entries;
+}
+
+void MapLiteralExpression::append(Entry entry)
+{
+    entries.push_back(std::move(entry));
+}
+
+std::shared_ptr<Expression> MapLiteralExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    PersistentMap map;
+    for (const auto& [key_expression, value_expression] : entries) {
+        auto key = key_expression->eval(env);
+        expect_key(key, "MapLiteralExpression: Key must not contain functions");
+        map = map.insert(key, value_expression->eval(env));
+    }
+    return std::make_shared<MapValue>(std::move(map));
+}
+
+std::string MapLiteralExpression::to_string() const noexcept
+{
+    std::string result = "{";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i > 0) result += ", ";
+        result += entries[i].first->to_string() + ": " + entries[i].second->to_string();
+    }
+    return result + "}";
+}
+
+std::pair<bool, Datatype> MapLiteralExpression::type_check(Environment& env) const noexcept
+{
+    // Como en los arrays: todas las llaves de un tipo y todos los valores de otro
+    Datatype key_type = Datatype::UnknownType;
+    Datatype value_type = Datatype::UnknownType;
+    for (const auto& [key_expression, value_expression] : entries) {
+        auto [key_ok, this_key_type] = key_expression->type_check(env);
+        auto [value_ok, this_value_type] = value_expression->type_check(env);
+        if (!key_ok || !value_ok || !is_key_type(this_key_type)) {
+            return {false, Datatype::UnknownType};
+        }
+        if ((key_type != Datatype::UnknownType && key_type != this_key_type) ||
+            (value_type != Datatype::UnknownType && value_type != this_value_type)) {
+            return {false, Datatype::UnknownType};
+        }
+        key_type = this_key_type;
+        value_type = this_value_type;
+    }
+    return {true, Datatype::MapType};
+}
+
+MapValue::MapValue(PersistentMap _map) noexcept
+    : map{std::move(_map)}
+{
+    // empty
+}
+
+const PersistentMap& MapValue::get_map() const noexcept
+{
+    return map;
+}
+
+std::shared_ptr<Expression> MapValue::eval(Environment&) const
+{
+    // Copiar el map solo copia la raíz
+    return std::make_shared<MapValue>(map);
+}
+
+std::string MapValue::to_string() const noexcept
+{
+    std::string result = "{";
+    bool first = true;
+    map.for_each([&](const std::shared_ptr<Expression>& key, const std::shared_ptr<Expression>& value) {
+        if (!first) result += ", ";
+        first = false;
+        result += key->to_string() + ": " + value->to_string();
+    });
+    return result + "}";
+}
+
+std::pair<bool, Datatype> MapValue::type_check(Environment&) const noexcept
+{
+    return {true, Datatype::MapType};
+}
+
+std::shared_ptr<Expression> MapGetExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto [map_result, key_result] = eval_operands(env);
+    const auto& map = expect_map(map_result, "MapGetExpression: First operand must be a map");
+    expect_key(key_result, "MapGetExpression: Key must not contain functions");
+    auto value = map.get_map().find(*key_result);
+    if (!value) {
+        throw std::runtime_error("MapGetExpression: Key not found");
+    }
+    return *value;
+}
+
+std::string MapGetExpression::to_string() const noexcept
+{
+    return "(get " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapGetExpression::type_check(Environment& env) const noexcept
+{
+    auto [map_ok, map_type] = get_left_expression()->type_check(env);
+    auto [key_ok, key_type] = get_right_expression()->type_check(env);
+    if (!map_ok || !key_ok || map_type != Datatype::MapType || !is_key_type(key_type)) {
+        return {false, Datatype::UnknownType};
+    }
+    Datatype value_type = infer_map_value_type(get_left_expression(), env);
+    if (value_type == Datatype::UnknownType) {
+        return {true, Datatype::IntType}; // Fallback para maps sin valores conocidos, como head
+    }
+    return {true, value_type};
+}
+
+std::shared_ptr<Expression> MapHasExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto [map_result, key_result] = eval_operands(env);
+    const auto& map = expect_map(map_result, "MapHasExpression: First operand must be a map");
+    expect_key(key_result, "MapHasExpression: Key must not contain functions");
+    return std::make_shared<BoolExpression>(map.get_map().find(*key_result) != nullptr);
+}
+
+std::string MapHasExpression::to_string() const noexcept
+{
+    return "(has " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapHasExpression::type_check(Environment& env) const noexcept
+{
+    auto [map_ok, map_type] = get_left_expression()->type_check(env);
+    auto [key_ok, key_type] = get_right_expression()->type_check(env);
+    if (!map_ok || !key_ok || map_type != Datatype::MapType || !is_key_type(key_type)) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::BoolType};
+}
+
+std::shared_ptr<Expression> MapRemoveExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto [map_result, key_result] = eval_operands(env);
+    const auto& map = expect_map(map_result, "MapRemoveExpression: First operand must be a map");
+    expect_key(key_result, "MapRemoveExpression: Key must not contain functions");
+    return std::make_shared<MapValue>(map.get_map().erase(*key_result));
+}
+
+std::string MapRemoveExpression::to_string() const noexcept
+{
+    return "(remove " + get_left_expression()->to_string() + " " + get_right_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapRemoveExpression::type_check(Environment& env) const noexcept
+{
+    auto [map_ok, map_type] = get_left_expression()->type_check(env);
+    auto [key_ok, key_type] = get_right_expression()->type_check(env);
+    if (!map_ok || !key_ok || map_type != Datatype::MapType || !is_key_type(key_type)) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::MapType};
+}
+
+std::shared_ptr<Expression> MapSizeExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    const auto& map = expect_map(get_expression()->eval(env), "MapSizeExpression: Operand must be a map");
+    return std::make_shared<IntExpression>(static_cast<int>(map.get_map().size()));
+}
+
+std::string MapSizeExpression::to_string() const noexcept
+{
+    return "(size " + get_expression()->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapSizeExpression::type_check(Environment& env) const noexcept
+{
+    auto [map_ok, map_type] = get_expression()->type_check(env);
+    if (!map_ok || map_type != Datatype::MapType) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::IntType};
+}
+
+MapPutExpression::MapPutExpression(std::shared_ptr<Expression> _map_expression, std::shared_ptr<Expression> _key_expression,
+                                   std::shared_ptr<Expression> _value_expression) noexcept
+    : map_expression{_map_expression}, key_expression{_key_expression}, value_expression{_value_expression}
+{
+    // empty
+}
+
+std::shared_ptr<Expression> MapPutExpression::get_map_expression() const noexcept
+{
+    return map_expression;
+}
+
+std::shared_ptr<Expression> MapPutExpression::get_key_expression() const noexcept
+{
+    return key_expression;
+}
+
+std::shared_ptr<Expression> MapPutExpression::get_value_expression() const noexcept
+{
+    return value_expression;
+}
+
+std::shared_ptr<Expression> MapPutExpression::eval(Environment& env) const
+{
+    ProfileScope profile{*this};
+    auto map_result = map_expression->eval(env);
+    auto key = key_expression->eval(env);
+    auto value = value_expression->eval(env);
+    const auto& map = expect_map(map_result, "MapPutExpression: First operand must be a map");
+    expect_key(key, "MapPutExpression: Key must not contain functions");
+    return std::make_shared<MapValue>(map.get_map().insert(key, value));
+}
+
+std::string MapPutExpression::to_string() const noexcept
+{
+    return "(put " + map_expression->to_string() + " " + key_expression->to_string() + " " +
+           value_expression->to_string() + ")";
+}
+
+std::pair<bool, Datatype> MapPutExpression::type_check(Environment& env) const noexcept
+{
+    auto [map_ok, map_type] = map_expression->type_check(env);
+    auto [key_ok, key_type] = key_expression->type_check(env);
+    auto [value_ok, value_type] = value_expression->type_check(env);
+    if (!map_ok || !key_ok || !value_ok || map_type != Datatype::MapType || !is_key_type(key_type)) {
+        return {false, Datatype::UnknownType};
+    }
+    Datatype stored_type = infer_map_value_type(map_expression, env);
+    if (stored_type != Datatype::UnknownType && stored_type != value_type) {
+        return {false, Datatype::UnknownType};
+    }
+    return {true, Datatype::MapType};
+}
+
+Datatype infer_map_value_type(std::shared_ptr<Expression> expression, Environment& env) noexcept
+{
+    if (auto literal = std::dynamic_pointer_cast<MapLiteralExpression>(expression)) {
+        if (literal->get_entries().empty()) return Datatype::UnknownType;
+        auto [value_ok, value_type] = literal->get_entries().front().second->type_check(env);
+        return value_ok ? value_type : Datatype::UnknownType;
+    }
+    if (auto put = std::dynamic_pointer_cast<MapPutExpression>(expression)) {
+        auto [value_ok, value_type] = put->get_value_expression()->type_check(env);
+        return value_ok ? value_type : Datatype::UnknownType;
+    }
+    if (auto remove = std::dynamic_pointer_cast<MapRemoveExpression>(expression)) {
+        return infer_map_value_type(remove->get_left_expression(), env);
+    }
+    if (auto variable = std::dynamic_pointer_cast<NameExpression>(expression)) {
+        expression = env.lookup(variable->get_name());
+    }
+    // Un MapValue en el entorno: placeholder de let o de parámetro
+    if (auto map = std::dynamic_pointer_cast<MapValue>(expression)) {
+        Datatype value_type = Datatype::UnknownType;
+        map->get_map().for_each([&](const std::shared_ptr<Expression>&, const std::shared_ptr<Expression>& value) {
+            if (value_type == Datatype::UnknownType) {
+                auto [value_ok, type] = value->type_check(env);
+                if (value_ok) value_type = type;
+            }
+        });
+        return value_type;
+    }
+    return Datatype::UnknownType;
+}
+
+std::shared_ptr<Expression> create_map_placeholder(std::shared_ptr<Expression> expression, Environment& env)
+{
+    Datatype value_type = infer_map_value_type(expression, env);
+    PersistentMap map;
+    if (value_type != Datatype::UnknownType) {
+        map = map.insert(std::make_shared<IntExpression>(0), create_pair_placeholder_recursive(value_type, env));
+    }
+    return std::make_shared<MapValue>(std::move(map));
+}
+
 /*
 
 nombre -> typedata para el entorno de check_type.
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "utils.hpp"
+#include "persistent_map.hpp"
 #include <string>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 // Sistema de tipos simplificado con enum
@@ -12,20 +14,31 @@ enum class Datatype {
     StringType,
     BoolType,
     PairType,        // Par de cualquier tipo
+    TupleType,       // Tupla; los tipos de los campos los da infer_tuple_shape
     ArrayType,       // Array de cualquier tipo
     IntArrayType,    // Array de enteros
     RealArrayType,   // Array de reales
     StringArrayType, // Array de strings
     BoolArrayType,   // Array de booleanos
     FunctionType,    // Función
+    MapType,         // Map de llaves sin funciones a cualquier tipo
     UnknownType      // Tipo desconocido/error
 };
 
 
 // Funciones auxiliares para el sistema de tipos
 Datatype get_array_type(Datatype base_type) noexcept;
+// Inversa de get_array_type; UnknownType si no es un array con tipo
+Datatype get_element_type(Datatype array_type) noexcept;
+class TupleExpression;
+// Forma de una tupla para el type checker: una tupla de placeholders con un
+// valor del tipo de cada campo (y la forma de los campos que son tuplas).
+// nullptr si no se puede saber sin evaluar.
+std::shared_ptr<TupleExpression> infer_tuple_shape(const std::shared_ptr<Expression>& expr, Environment& env);
+// range, map o filter: se recorren sin crear el array (length los cuenta así)
+bool is_sequence_expression(const Expression& expression) noexcept;
 std::pair<Datatype, Datatype> infer_function_types(std::shared_ptr<Expression> body, 
-                                                  std::string param_name, 
+                                                  const std::vector<std::string>& param_names, 
                                                   Environment& env);
 
 
@@ -379,6 +392,41 @@ public:
 
 
 
+// (a, b, c, ...): tres o más campos guardados en un solo vector. Con dos
+// campos sigue siendo un par.
+class TupleExpression : public Expression {
+public:
+    TupleExpression(std::vector<std::shared_ptr<Expression>> _elements) noexcept;
+
+    const std::vector<std::shared_ptr<Expression>>& get_elements() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::vector<std::shared_ptr<Expression>> elements;
+};
+
+// t.N: campo N (desde 0) de una tupla
+class TupleFieldExpression : public UnaryExpression {
+public:
+    TupleFieldExpression(std::shared_ptr<Expression> _tuple_expression, std::size_t _index) noexcept;
+
+    std::size_t get_index() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::size_t index;
+};
+
 class RtoSExpression : public UnaryExpression {
 public:
     using UnaryExpression::UnaryExpression;
@@ -459,17 +507,17 @@ private:
 
 class FunExpression : public Expression {
 public:
-    FunExpression(std::shared_ptr<Expression> _function_name_expression, std::shared_ptr<Expression> _parameter_name_expression, std::shared_ptr<Expression> _body_expression) noexcept;
+    FunExpression(std::shared_ptr<Expression> _function_name_expression, std::vector<std::shared_ptr<Expression>> _parameter_name_expressions, std::shared_ptr<Expression> _body_expression) noexcept;
 
     std::shared_ptr<Expression> get_function_name_expression() const noexcept;
     
-    std::shared_ptr<Expression> get_parameter_name_expression() const noexcept;
+    const std::vector<std::shared_ptr<Expression>>& get_parameter_name_expressions() const noexcept;
 
     std::shared_ptr<Expression> get_body_expression() const noexcept;
     
     std::string get_name() const noexcept;
     
-    std::string get_parameter_name() const noexcept;
+    std::vector<std::string> get_parameter_names() const noexcept;
 
     std::shared_ptr<Expression> eval(Environment& env) const override;
 
@@ -479,32 +527,58 @@ public:
 
 private:
     std::shared_ptr<Expression> function_name_expression;
-    std::shared_ptr<Expression> parameter_name_expression;
+    std::vector<std::shared_ptr<Expression>> parameter_name_expressions;
     std::shared_ptr<Expression> body_expression;
 };
 
+// La expresión derecha es el primer argumento; get_arguments tiene todos
 class CallExpression : public BinaryExpression {
     public:
-        using BinaryExpression::BinaryExpression;
+        CallExpression(std::shared_ptr<Expression> _function_name, std::shared_ptr<Expression> _argument) noexcept;
+
+        CallExpression(std::shared_ptr<Expression> _function_name, std::vector<std::shared_ptr<Expression>> _arguments) noexcept;
+
+        const std::vector<std::shared_ptr<Expression>>& get_arguments() const noexcept;
     
         std::shared_ptr<Expression> eval(Environment& env) const override;
     
         std::string to_string() const noexcept override;
         
         std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
+
+    private:
+        std::vector<std::shared_ptr<Expression>> arguments;
     };
     
 
+// Variable de un let: nombre (NameExpression) y expresión
+using LetBinding = std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>;
+
     class LetExpression : public Expression {
 public:
     LetExpression(std::shared_ptr<Expression> _var_name, std::shared_ptr<Expression> _var_expression, std::shared_ptr<Expression> _body_expression) noexcept;
 
+    // let a = e1, b = e2 in cuerpo end: todas las variables van en un solo
+    // entorno y cada expresión ve las anteriores. Con recursive (letrec) las
+    // expresiones son FunExpression que se pueden llamar entre sí.
+    LetExpression(std::vector<LetBinding> _bindings, std::shared_ptr<Expression> _body_expression, bool _recursive = false) noexcept;
+
+    // Primera variable
     std::shared_ptr<Expression> get_var_name() const noexcept;
     
     std::shared_ptr<Expression> get_var_expression() const noexcept;
 
+    const std::vector<LetBinding>& get_bindings() const noexcept;
+
+    bool is_recursive() const noexcept;
+
     std::shared_ptr<Expression> get_body_expression() const noexcept;
 
+    // --lazy-let: la variable index se guarda como ThunkExpression
+    void set_lazy(std::size_t index) noexcept;
+
+    bool is_lazy(std::size_t index) const noexcept;
+
     std::shared_ptr<Expression> eval(Environment& env) const override;
 
     std::string to_string() const noexcept override;
@@ -512,11 +586,39 @@ public:
     std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
 
 private:
-    std::shared_ptr<Expression> var_name;
-    std::shared_ptr<Expression> var_expression;
+    std::vector<LetBinding> bindings;
     std::shared_ptr<Expression> body_expression;
+    bool recursive;
+    std::vector<bool> lazy;
 };
 
+// Variable de un let perezoso: la expresión se evalúa en el entorno del let
+// la primera vez que se lee la variable (NameExpression) y el valor se
+// guarda para las siguientes
+class ThunkExpression : public Expression {
+public:
+    ThunkExpression(std::shared_ptr<Expression> _expression, Environment _env) noexcept;
+
+    std::shared_ptr<Expression> force() const;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+    
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::shared_ptr<Expression> expression;
+    mutable Environment env;
+    mutable std::shared_ptr<Expression> value;
+    // Con --parallel dos hilos pueden leer la variable a la vez
+    mutable std::once_flag evaluated;
+};
+
+// letrec: agrega a local_env los closures de bindings, que capturan env.
+// Retorna false si alguna variable no es una función.
+bool add_recursive_bindings(const std::vector<LetBinding>& bindings, const Environment& env, Environment& local_env);
+
 class PrintExpression : public UnaryExpression {
 public:
     using UnaryExpression::UnaryExpression;
@@ -533,6 +635,9 @@ public:
     ArrayExpression(std::vector<std::shared_ptr<Expression>> _elements) noexcept;
     
     const std::vector<std::shared_ptr<Expression>>& get_elements() const noexcept;
+
+    // Solo para el parser: agrega al final sin copiar la lista
+    void append(std::shared_ptr<Expression> element);
     
     std::shared_ptr<Expression> eval(Environment& env) const override;
     
@@ -566,6 +671,66 @@ public:
     std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
 };
 
+// arr[i]
+class IndexExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
+};
+
+// sort(arr): copia ordenada de un array de int, real, string o bool
+class SortExpression : public UnaryExpression {
+public:
+    using UnaryExpression::UnaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
+};
+
+// bsearch(arr, x): posición de x en un array ordenado, o -1
+class BsearchExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
+};
+
+// arr[a:b]: los elementos de a a b - 1, con 0 <= a <= b <= length(arr)
+class SliceExpression : public Expression {
+public:
+    SliceExpression(std::shared_ptr<Expression> _array_expression, std::shared_ptr<Expression> _begin_expression,
+                    std::shared_ptr<Expression> _end_expression) noexcept;
+
+    std::shared_ptr<Expression> get_array_expression() const noexcept;
+
+    std::shared_ptr<Expression> get_begin_expression() const noexcept;
+
+    std::shared_ptr<Expression> get_end_expression() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
+
+private:
+    std::shared_ptr<Expression> array_expression;
+    std::shared_ptr<Expression> begin_expression;
+    std::shared_ptr<Expression> end_expression;
+};
+
 class LengthExpression : public UnaryExpression {
 public:
     using UnaryExpression::UnaryExpression;
@@ -605,5 +770,187 @@ public:
     std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
 };
 
+// Secuencias: range(a, b) son los enteros de a a b (inclusive) y map,
+// filter y fold reciben el nombre de una función global. Al evaluarse, una
+// cadena como fold(f, 0, filter(g, map(h, range(1, n)))) se recorre hasta su
+// origen y se aplica elemento por elemento en un solo ciclo: range no crea
+// el array y los map/filter intermedios tampoco. Solo se crea un array si el
+// resultado de range, map o filter se usa como valor.
+class RangeExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+// Izquierda: nombre de la función (NameExpression); derecha: la secuencia
+class MapExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+class FilterExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+// fold(f, inicial, secuencia): f(acumulado, elemento) de izquierda a derecha
+class FoldExpression : public Expression {
+public:
+    FoldExpression(std::shared_ptr<Expression> _function_name, std::shared_ptr<Expression> _initial_expression,
+                   std::shared_ptr<Expression> _sequence_expression) noexcept;
+
+    std::shared_ptr<Expression> get_function_name() const noexcept;
+
+    std::shared_ptr<Expression> get_initial_expression() const noexcept;
+
+    std::shared_ptr<Expression> get_sequence_expression() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::shared_ptr<Expression> function_name;
+    std::shared_ptr<Expression> initial_expression;
+    std::shared_ptr<Expression> sequence_expression;
+};
+
+// Maps: {llave: valor, ...} se evalúa a un MapValue; get, put, has,
+// remove y size operan sobre él. put y remove retornan un map nuevo y el
+// original no cambia.
+class MapLiteralExpression : public Expression {
+public:
+    using Entry = std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>;
+
+    MapLiteralExpression(std::vector<Entry> _entries) noexcept;
+
+    const std::vector<Entry>& get_entries() const noexcept;
+
+    // Solo para el parser: agrega al final sin copiar la lista
+    void append(Entry entry);
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::vector<Entry> entries;
+};
+
+// Valor de un map ya evaluado
+class MapValue : public Expression {
+public:
+    MapValue(PersistentMap _map) noexcept;
+
+    const PersistentMap& get_map() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    PersistentMap map;
+};
+
+// get(map, llave): error si la llave no está
+class MapGetExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+class MapHasExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+class MapRemoveExpression : public BinaryExpression {
+public:
+    using BinaryExpression::BinaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+class MapSizeExpression : public UnaryExpression {
+public:
+    using UnaryExpression::UnaryExpression;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+};
+
+// put(map, llave, valor)
+class MapPutExpression : public Expression {
+public:
+    MapPutExpression(std::shared_ptr<Expression> _map_expression, std::shared_ptr<Expression> _key_expression,
+                     std::shared_ptr<Expression> _value_expression) noexcept;
+
+    std::shared_ptr<Expression> get_map_expression() const noexcept;
+
+    std::shared_ptr<Expression> get_key_expression() const noexcept;
+
+    std::shared_ptr<Expression> get_value_expression() const noexcept;
+
+    std::shared_ptr<Expression> eval(Environment& env) const override;
+
+    std::string to_string() const noexcept override;
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override;
+
+private:
+    std::shared_ptr<Expression> map_expression;
+    std::shared_ptr<Expression> key_expression;
+    std::shared_ptr<Expression> value_expression;
+};
+
+// Tipo de los valores del map que produce expression, buscando un valor de
+// muestra en literales, put y variables; UnknownType si no hay ninguno
+Datatype infer_map_value_type(std::shared_ptr<Expression> expression, Environment& env) noexcept;
+
+// MapValue con una entrada del tipo de valor inferido, para los entornos de
+// type_check
+std::shared_ptr<Expression> create_map_placeholder(std::shared_ptr<Expression> expression, Environment& env);
+
 // Función auxiliar para inferir tipos de expresiones anidadas
 
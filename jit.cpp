@@ -0,0 +1,513 @@
+#include "jit.hpp"
+#include "trace.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+bool jit_enabled = false;
+long jit_threshold = 1000;
+
+namespace {
+
+struct Unsupported {
+    std::string reason;
+};
+
+// Una función traducida para tipos de parámetros concretos
+struct Specialization {
+    std::string name;
+    std::shared_ptr<Closure> closure;
+    std::vector<Datatype> parameter_types;
+    Datatype return_type = Datatype::UnknownType;
+    std::string symbol;
+};
+
+struct Binding {
+    std::string name;
+    Datatype type;
+    std::string identifier;
+};
+
+using Scope = std::vector<Binding>;
+
+// Los parámetros se llaman p0, p1, ... en el código generado
+Scope parameter_scope(const Specialization& function)
+{
+    Scope scope;
+    const auto& names = function.closure->get_parameter_names();
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        scope.push_back({names[i], function.parameter_types[i], "p" + std::to_string(i)});
+    }
+    return scope;
+}
+
+const char* c_type(Datatype type)
+{
+    switch (type) {
+        case Datatype::IntType: return "int";
+        case Datatype::RealType: return "double";
+        case Datatype::BoolType: return "bool";
+        default: throw Unsupported{"only int, real and bool values can be compiled"};
+    }
+}
+
+const char* scalar_field(Datatype type)
+{
+    switch (type) {
+        case Datatype::IntType: return "i";
+        case Datatype::RealType: return "r";
+        default: return "b";
+    }
+}
+
+std::string describe(const Expression& node)
+{
+    std::string text = node.to_string();
+    if (text.size() > 40) {
+        text = text.substr(0, 37) + "...";
+    }
+    return text;
+}
+
+// Traduce el cuerpo de las funciones a C++. El mismo recorrido sirve para
+// inferir tipos (code == nullptr, los tipos desconocidos se toleran) y para
+// emitir el código (strict, todo tipo debe estar resuelto).
+class Translator
+{
+public:
+    explicit Translator(const Environment& _globals) : globals{_globals} {}
+
+    Specialization& request(const std::string& name, const std::vector<Datatype>& parameter_types);
+    void infer();
+    std::string emit(const Specialization& entry);
+
+private:
+    Datatype visit(const Expression& node, Scope& scope, std::string* code);
+    Datatype visit_binary(const BinaryExpression& node, Scope& scope, std::string* code);
+    Datatype visit_unary(const UnaryExpression& node, Scope& scope, std::string* code);
+
+    std::string fresh(const char* prefix) { return prefix + std::to_string(counter++); }
+
+    const Environment& globals;
+    std::map<std::pair<std::string, std::vector<Datatype>>, std::size_t> index;
+    std::vector<std::unique_ptr<Specialization>> functions;
+    bool strict = false;
+    int counter = 0;
+};
+
+Specialization& Translator::request(const std::string& name, const std::vector<Datatype>& parameter_types)
+{
+    auto key = std::make_pair(name, parameter_types);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        return *functions[found->second];
+    }
+    auto closure = std::dynamic_pointer_cast<Closure>(globals.lookup(name));
+    if (!closure) {
+        throw Unsupported{"function " + name + " does not exist"};
+    }
+    if (closure->get_parameter_names().size() != parameter_types.size()) {
+        throw Unsupported{"wrong number of arguments for " + name};
+    }
+    for (Datatype type : parameter_types) {
+        c_type(type);
+    }
+    auto function = std::make_unique<Specialization>();
+    function->name = name;
+    function->closure = closure;
+    function->parameter_types = parameter_types;
+    function->symbol = "f" + std::to_string(functions.size());
+    index.emplace(key, functions.size());
+    functions.push_back(std::move(function));
+    return *functions.back();
+}
+
+// Punto fijo: las llamadas recursivas empiezan con tipo desconocido y el if
+// toma el tipo de la rama conocida hasta que nada cambia
+void Translator::infer()
+{
+    bool changed = true;
+    for (int round = 0; changed && round < 32; ++round) {
+        changed = false;
+        for (std::size_t i = 0; i < functions.size(); ++i) {
+            auto& function = *functions[i];
+            Scope scope = parameter_scope(function);
+            Datatype result = visit(*function.closure->get_body_expression(), scope, nullptr);
+            if (result == Datatype::UnknownType || result == function.return_type) continue;
+            if (function.return_type != Datatype::UnknownType) {
+                throw Unsupported{function.name + " returns values of different types"};
+            }
+            c_type(result);
+            function.return_type = result;
+            changed = true;
+        }
+    }
+    for (const auto& function : functions) {
+        if (function->return_type == Datatype::UnknownType) {
+            throw Unsupported{"cannot infer the return type of " + function->name};
+        }
+    }
+}
+
+std::string Translator::emit(const Specialization& entry)
+{
+    strict = true;
+    std::ostringstream out;
+    out << "// Generado por el JIT de funciones a partir de " << entry.name << "\n"
+        << "#include <stdexcept>\n\n"
+        << "union JitScalar { int i; double r; bool b; };\n\n"
+        << "static inline int jit_div(int a, int b)\n{\n"
+        << "    if (b == 0) throw std::runtime_error(\"Division by zero\");\n"
+        << "    return a / b;\n}\n\n"
+        << "static inline int jit_mod(int a, int b)\n{\n"
+        << "    if (b == 0) throw std::runtime_error(\"Division by zero\");\n"
+        << "    return a % b;\n}\n\n";
+    auto parameters = [](const Specialization& function) {
+        std::string text;
+        for (std::size_t i = 0; i < function.parameter_types.size(); ++i) {
+            if (i > 0) text += ", ";
+            text += std::string{c_type(function.parameter_types[i])} + " p" + std::to_string(i);
+        }
+        return text;
+    };
+    for (const auto& function : functions) {
+        out << "static " << c_type(function->return_type) << " " << function->symbol
+            << "(" << parameters(*function) << ");  // " << function->name << "\n";
+    }
+    out << "\n";
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        const auto& function = *functions[i];
+        Scope scope = parameter_scope(function);
+        std::string body;
+        visit(*function.closure->get_body_expression(), scope, &body);
+        out << "static " << c_type(function.return_type) << " " << function.symbol
+            << "(" << parameters(function) << ")\n{\n    return " << body << ";\n}\n\n";
+    }
+    out << "extern \"C\" void jit_entry(const JitScalar* arguments, JitScalar* result)\n{\n"
+        << "    result->" << scalar_field(entry.return_type) << " = " << entry.symbol << "(";
+    for (std::size_t i = 0; i < entry.parameter_types.size(); ++i) {
+        if (i > 0) out << ", ";
+        out << "arguments[" << i << "]." << scalar_field(entry.parameter_types[i]);
+    }
+    out << ");\n}\n";
+    return out.str();
+}
+
+Datatype Translator::visit(const Expression& node, Scope& scope, std::string* code)
+{
+    if (auto n = dynamic_cast<const IntExpression*>(&node)) {
+        if (code) *code = "(" + std::to_string(n->get_value()) + ")";
+        return Datatype::IntType;
+    }
+    if (auto n = dynamic_cast<const RealExpression*>(&node)) {
+        if (!std::isfinite(n->get_value())) {
+            throw Unsupported{"non-finite real literal"};
+        }
+        if (code) {
+            char text[64];
+            snprintf(text, sizeof text, "(%.17g)", n->get_value());
+            *code = text;
+            if (code->find_first_of(".e") == std::string::npos) {
+                code->insert(code->size() - 1, ".0");
+            }
+        }
+        return Datatype::RealType;
+    }
+    if (auto n = dynamic_cast<const BoolExpression*>(&node)) {
+        if (code) *code = n->get_value() ? "true" : "false";
+        return Datatype::BoolType;
+    }
+    if (auto n = dynamic_cast<const NameExpression*>(&node)) {
+        for (auto it = scope.rbegin(); it != scope.rend(); ++it) {
+            if (it->name == n->get_name()) {
+                if (code) *code = it->identifier;
+                return it->type;
+            }
+        }
+        throw Unsupported{"free variable " + n->get_name()};
+    }
+    if (auto n = dynamic_cast<const LetExpression*>(&node)) {
+        if (n->is_recursive()) {
+            throw Unsupported{"local functions (letrec)"};
+        }
+        // Todas las variables en una sola lambda, en orden
+        std::size_t depth = scope.size();
+        std::string declarations;
+        std::string body_code;
+        Datatype body_type;
+        try {
+            for (const auto& [var_name, var_expression] : n->get_bindings()) {
+                auto name = std::dynamic_pointer_cast<NameExpression>(var_name);
+                if (!name) {
+                    throw Unsupported{"let without a variable name"};
+                }
+                std::string value_code;
+                Datatype value_type = visit(*var_expression, scope, code ? &value_code : nullptr);
+                std::string identifier = fresh("v");
+                scope.push_back({name->get_name(), value_type, identifier});
+                if (code) {
+                    declarations += "const " + std::string{c_type(value_type)} + " " + identifier + " = "
+                        + value_code + "; ";
+                }
+            }
+            body_type = visit(*n->get_body_expression(), scope, code ? &body_code : nullptr);
+        } catch (...) {
+            scope.resize(depth);
+            throw;
+        }
+        scope.resize(depth);
+        if (code) {
+            *code = "[&]() { " + declarations + "return " + body_code + "; }()";
+        }
+        return body_type;
+    }
+    if (auto n = dynamic_cast<const IfElseExpression*>(&node)) {
+        std::string condition_code, true_code, false_code;
+        Datatype condition = visit(*n->get_condition_expression(), scope, code ? &condition_code : nullptr);
+        if (condition != Datatype::BoolType && (strict || condition != Datatype::UnknownType)) {
+            throw Unsupported{"if condition is not a bool"};
+        }
+        Datatype if_true = visit(*n->get_true_expression(), scope, code ? &true_code : nullptr);
+        Datatype if_false = visit(*n->get_false_expression(), scope, code ? &false_code : nullptr);
+        if (if_true != Datatype::UnknownType && if_false != Datatype::UnknownType && if_true != if_false) {
+            throw Unsupported{"if branches have different types"};
+        }
+        if (code) *code = "(" + condition_code + " ? " + true_code + " : " + false_code + ")";
+        return if_true != Datatype::UnknownType ? if_true : if_false;
+    }
+    if (auto n = dynamic_cast<const CallExpression*>(&node)) {
+        auto name = std::dynamic_pointer_cast<NameExpression>(n->get_left_expression());
+        for (const auto& binding : scope) {
+            if (binding.name == name->get_name()) {
+                throw Unsupported{"call through local " + binding.name};
+            }
+        }
+        std::vector<Datatype> arguments;
+        std::string arguments_code;
+        bool known = true;
+        for (const auto& argument : n->get_arguments()) {
+            std::string argument_code;
+            Datatype type = visit(*argument, scope, code ? &argument_code : nullptr);
+            known = known && type != Datatype::UnknownType;
+            arguments.push_back(type);
+            if (!arguments_code.empty()) arguments_code += ", ";
+            arguments_code += argument_code;
+        }
+        if (!known) {
+            if (strict) throw Unsupported{"cannot infer the arguments of " + name->get_name()};
+            return Datatype::UnknownType;
+        }
+        auto& callee = request(name->get_name(), arguments);
+        if (strict && callee.return_type == Datatype::UnknownType) {
+            throw Unsupported{"cannot infer the return type of " + callee.name};
+        }
+        if (code) *code = callee.symbol + "(" + arguments_code + ")";
+        return callee.return_type;
+    }
+    if (auto n = dynamic_cast<const BinaryExpression*>(&node)) {
+        return visit_binary(*n, scope, code);
+    }
+    if (auto n = dynamic_cast<const UnaryExpression*>(&node)) {
+        return visit_unary(*n, scope, code);
+    }
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+Datatype Translator::visit_binary(const BinaryExpression& node, Scope& scope, std::string* code)
+{
+    std::string left_code, right_code;
+    Datatype left = visit(*node.get_left_expression(), scope, code ? &left_code : nullptr);
+    Datatype right = visit(*node.get_right_expression(), scope, code ? &right_code : nullptr);
+    if (left != Datatype::UnknownType && right != Datatype::UnknownType && left != right) {
+        throw Unsupported{"mixed operand types in " + describe(node)};
+    }
+    Datatype operand = left != Datatype::UnknownType ? left : right;
+    bool numeric = operand == Datatype::IntType || operand == Datatype::RealType || operand == Datatype::UnknownType;
+    auto infix = [&](const char* op) {
+        if (code) *code = "(" + left_code + " " + op + " " + right_code + ")";
+    };
+
+    if (dynamic_cast<const AddExpression*>(&node) || dynamic_cast<const SubExpression*>(&node)
+        || dynamic_cast<const MulExpression*>(&node)) {
+        if (!numeric) throw Unsupported{"arithmetic on non-numeric values"};
+        infix(dynamic_cast<const AddExpression*>(&node) ? "+" : dynamic_cast<const SubExpression*>(&node) ? "-" : "*");
+        return operand;
+    }
+    if (dynamic_cast<const DivExpression*>(&node)) {
+        if (!numeric) throw Unsupported{"arithmetic on non-numeric values"};
+        if (operand == Datatype::IntType) {
+            if (code) *code = "jit_div(" + left_code + ", " + right_code + ")";
+        } else {
+            infix("/");
+        }
+        return operand;
+    }
+    if (dynamic_cast<const ModExpression*>(&node)) {
+        if (operand != Datatype::IntType && operand != Datatype::UnknownType) {
+            throw Unsupported{"modulo on non-integer values"};
+        }
+        if (code) *code = "jit_mod(" + left_code + ", " + right_code + ")";
+        return Datatype::IntType;
+    }
+    if (dynamic_cast<const LessExpression*>(&node) || dynamic_cast<const LessEqExpression*>(&node)
+        || dynamic_cast<const GreaterExpression*>(&node) || dynamic_cast<const GreaterEqExpression*>(&node)) {
+        if (!numeric) throw Unsupported{"comparison of non-numeric values"};
+        infix(dynamic_cast<const LessExpression*>(&node) ? "<"
+              : dynamic_cast<const LessEqExpression*>(&node) ? "<="
+              : dynamic_cast<const GreaterExpression*>(&node) ? ">" : ">=");
+        return Datatype::BoolType;
+    }
+    if (dynamic_cast<const EqualExpression*>(&node) || dynamic_cast<const NotEqualExpression*>(&node)) {
+        if (!numeric && operand != Datatype::BoolType) throw Unsupported{"equality on non-scalar values"};
+        infix(dynamic_cast<const EqualExpression*>(&node) ? "==" : "!=");
+        return Datatype::BoolType;
+    }
+    // and/or se evalúan completos en el intérprete: sin cortocircuito
+    if (dynamic_cast<const AndExpression*>(&node) || dynamic_cast<const OrExpression*>(&node)
+        || dynamic_cast<const XorExpression*>(&node)) {
+        if (operand != Datatype::BoolType && operand != Datatype::UnknownType) {
+            throw Unsupported{"logical operator on non-boolean values"};
+        }
+        infix(dynamic_cast<const AndExpression*>(&node) ? "&" : dynamic_cast<const OrExpression*>(&node) ? "|" : "!=");
+        return Datatype::BoolType;
+    }
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+Datatype Translator::visit_unary(const UnaryExpression& node, Scope& scope, std::string* code)
+{
+    std::string operand_code;
+    Datatype operand = visit(*node.get_expression(), scope, code ? &operand_code : nullptr);
+    auto require = [&](Datatype expected, const char* what) {
+        if (operand != expected && (strict || operand != Datatype::UnknownType)) {
+            throw Unsupported{std::string{what} + " applied to the wrong type"};
+        }
+    };
+
+    if (dynamic_cast<const PrintExpression*>(&node)) {
+        if (code) *code = operand_code;
+        return operand;
+    }
+    if (dynamic_cast<const NotExpression*>(&node)) {
+        require(Datatype::BoolType, "not");
+        if (code) *code = "(!" + operand_code + ")";
+        return Datatype::BoolType;
+    }
+    if (dynamic_cast<const NegExpression*>(&node)) {
+        // Como en NegExpression::eval, el negativo de un real se trunca a entero
+        if (operand == Datatype::RealType) {
+            if (code) *code = "((int)(-" + operand_code + "))";
+        } else {
+            require(Datatype::IntType, "negation");
+            if (code) *code = "(-" + operand_code + ")";
+        }
+        return Datatype::IntType;
+    }
+    if (dynamic_cast<const ItoRExpression*>(&node)) {
+        require(Datatype::IntType, "itor");
+        if (code) *code = "((double)" + operand_code + ")";
+        return Datatype::RealType;
+    }
+    if (dynamic_cast<const RtoIExpression*>(&node)) {
+        require(Datatype::RealType, "rtoi");
+        if (code) *code = "((int)" + operand_code + ")";
+        return Datatype::IntType;
+    }
+    throw Unsupported{"unsupported expression " + describe(node)};
+}
+
+std::string temporary_directory()
+{
+    const char* base = getenv("TMPDIR");
+    std::string pattern = std::string{base != nullptr ? base : "/tmp"} + "/jitXXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    if (mkdtemp(buffer.data()) == nullptr) {
+        return "";
+    }
+    return buffer.data();
+}
+
+std::string first_line(const std::string& path)
+{
+    std::ifstream in{path};
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// Las bibliotecas cargadas no se descargan: el código nativo se puede seguir
+// llamando hasta el final del programa
+std::vector<void*> loaded_libraries;
+
+} // namespace
+
+bool jit_compile(const std::string& name, const std::vector<Datatype>& parameter_types, const Environment& globals,
+                 NativeFunction& result, std::string& reason)
+{
+    TraceScope jit_trace{"jit", name};
+    std::string source;
+    Datatype return_type;
+    try {
+        Translator translator{globals};
+        auto& entry = translator.request(name, parameter_types);
+        translator.infer();
+        source = translator.emit(entry);
+        return_type = entry.return_type;
+    } catch (const Unsupported& e) {
+        reason = e.reason;
+        return false;
+    }
+
+    std::string directory = temporary_directory();
+    if (directory.empty()) {
+        reason = "could not create a temporary directory";
+        return false;
+    }
+    std::string source_path = directory + "/jit.cpp";
+    std::string library_path = directory + "/jit.so";
+    std::string log_path = directory + "/jit.log";
+    {
+        std::ofstream out{source_path};
+        out << source;
+    }
+    // JIT_CXX permite elegir el compilador; por defecto el del sistema
+    const char* compiler = getenv("JIT_CXX");
+    std::string command = std::string{compiler != nullptr ? compiler : "c++"}
+        + " -std=c++17 -O2 -fwrapv -shared -fPIC -o '" + library_path + "' '" + source_path + "' 2> '" + log_path + "'";
+    bool compiled = std::system(command.c_str()) == 0;
+
+    void* library = nullptr;
+    if (!compiled) {
+        reason = "compiler failed: " + first_line(log_path);
+    } else if ((library = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL)) == nullptr) {
+        reason = dlerror();
+    }
+    unlink(source_path.c_str());
+    unlink(library_path.c_str());
+    unlink(log_path.c_str());
+    rmdir(directory.c_str());
+    if (library == nullptr) {
+        return false;
+    }
+
+    auto entry = reinterpret_cast<JitEntry>(dlsym(library, "jit_entry"));
+    if (entry == nullptr) {
+        reason = "jit_entry not found";
+        dlclose(library);
+        return false;
+    }
+    loaded_libraries.push_back(library);
+    result.entry = entry;
+    result.parameter_types = parameter_types;
+    result.return_type = return_type;
+    return true;
+}
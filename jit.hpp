@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "expression.hpp"
+
+// JIT nativo (--jit): cuando una función del backend de closures pasa de
+// jit_threshold llamadas, se traduce a C++ con tipos fijos (int, real o
+// bool), se compila con el compilador del sistema como biblioteca
+// compartida y se carga con dlopen. Solo se aceptan funciones cuyo cuerpo usa
+// aritmética, comparaciones, if, let y llamadas a otras funciones aceptables;
+// el resto sigue en el backend de closures.
+extern bool jit_enabled;
+extern long jit_threshold;
+
+// Valor escalar que cruza la frontera con el código nativo
+union JitScalar {
+    int i;
+    double r;
+    bool b;
+};
+
+// arguments apunta a un escalar por parámetro
+using JitEntry = void (*)(const JitScalar* arguments, JitScalar* result);
+
+struct NativeFunction {
+    JitEntry entry = nullptr;
+    std::vector<Datatype> parameter_types;
+    Datatype return_type = Datatype::UnknownType;
+};
+
+// Compila name especializada para parameter_types. Si la función no se puede
+// traducir o el compilador falla, retorna false y deja el motivo en reason.
+bool jit_compile(const std::string& name, const std::vector<Datatype>& parameter_types, const Environment& globals,
+                 NativeFunction& result, std::string& reason);
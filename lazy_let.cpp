@@ -0,0 +1,126 @@
+#include "lazy_let.hpp"
+#include "purity.hpp"
+
+bool lazy_let_enabled = false;
+
+namespace {
+
+// true si evaluar node siempre lee la variable name
+bool forces(const Expression& node, const std::string& name)
+{
+    if (auto variable = dynamic_cast<const NameExpression*>(&node)) {
+        return variable->get_name() == name;
+    }
+    if (auto if_else = dynamic_cast<const IfElseExpression*>(&node)) {
+        // Solo es seguro si la condición la lee o si la leen las dos ramas
+        return forces(*if_else->get_condition_expression(), name) ||
+               (forces(*if_else->get_true_expression(), name) && forces(*if_else->get_false_expression(), name));
+    }
+    if (auto let = dynamic_cast<const LetExpression*>(&node)) {
+        // Las variables del let pueden ser perezosas a su vez: solo cuenta el
+        // cuerpo, si no la oculta
+        for (const auto& [var_name, var_expression] : let->get_bindings()) {
+            if (binding_name(var_name) == name) return false;
+        }
+        return forces(*let->get_body_expression(), name);
+    }
+    if (auto call = dynamic_cast<const CallExpression*>(&node)) {
+        // La llamada lee el nombre de la función antes que los argumentos
+        if (forces(*call->get_left_expression(), name)) return true;
+        for (const auto& argument : call->get_arguments()) {
+            if (forces(*argument, name)) return true;
+        }
+        return false;
+    }
+    if (auto array = dynamic_cast<const ArrayExpression*>(&node)) {
+        for (const auto& element : array->get_elements()) {
+            if (forces(*element, name)) return true;
+        }
+        return false;
+    }
+    if (auto tuple = dynamic_cast<const TupleExpression*>(&node)) {
+        for (const auto& element : tuple->get_elements()) {
+            if (forces(*element, name)) return true;
+        }
+        return false;
+    }
+    if (auto assignment = dynamic_cast<const AssignmentExpression*>(&node)) {
+        return forces(*assignment->get_right_expression(), name);
+    }
+    // map, filter y fold también leen el nombre de la función
+    if (dynamic_cast<const MapExpression*>(&node) || dynamic_cast<const FilterExpression*>(&node)) {
+        const auto& binary = static_cast<const BinaryExpression&>(node);
+        return forces(*binary.get_left_expression(), name) || forces(*binary.get_right_expression(), name);
+    }
+    if (auto fold = dynamic_cast<const FoldExpression*>(&node)) {
+        return forces(*fold->get_function_name(), name) || forces(*fold->get_initial_expression(), name) ||
+               forces(*fold->get_sequence_expression(), name);
+    }
+    if (auto map = dynamic_cast<const MapLiteralExpression*>(&node)) {
+        for (const auto& [key, value] : map->get_entries()) {
+            if (forces(*key, name) || forces(*value, name)) return true;
+        }
+        return false;
+    }
+    if (auto put = dynamic_cast<const MapPutExpression*>(&node)) {
+        return forces(*put->get_map_expression(), name) || forces(*put->get_key_expression(), name) ||
+               forces(*put->get_value_expression(), name);
+    }
+    if (auto slice = dynamic_cast<const SliceExpression*>(&node)) {
+        return forces(*slice->get_array_expression(), name) || forces(*slice->get_begin_expression(), name) ||
+               forces(*slice->get_end_expression(), name);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpression*>(&node)) {
+        return forces(*unary->get_expression(), name);
+    }
+    if (auto binary = dynamic_cast<const BinaryExpression*>(&node)) {
+        return forces(*binary->get_left_expression(), name) || forces(*binary->get_right_expression(), name);
+    }
+    // fun: el cuerpo se evalúa después, si se llama
+    return false;
+}
+
+class LazyLetMarker : public PurityAnalyzer
+{
+public:
+    using PurityAnalyzer::PurityAnalyzer;
+
+    std::size_t marked = 0;
+
+protected:
+    void on_let(LetExpression& node, const std::vector<PuritySummary>& summaries) override
+    {
+        const auto& bindings = node.get_bindings();
+        // De atrás hacia adelante: al decidir una variable ya se sabe cuáles
+        // de las siguientes se evalúan en el momento
+        for (std::size_t i = bindings.size(); i-- > 0;) {
+            if (!summaries[i].pure || !summaries[i].expensive) continue;
+            std::string name = binding_name(bindings[i].first);
+            bool used = false;
+            bool shadowed = false;
+            for (std::size_t j = i + 1; j < bindings.size() && !used; ++j) {
+                used = !node.is_lazy(j) && forces(*bindings[j].second, name);
+                if (binding_name(bindings[j].first) == name) {
+                    shadowed = true;
+                    break;
+                }
+            }
+            if (!used && !shadowed) {
+                used = forces(*node.get_body_expression(), name);
+            }
+            if (!used) {
+                node.set_lazy(i);
+                ++marked;
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::size_t analyze_lazy_lets(Expression& program, const Environment& globals)
+{
+    LazyLetMarker marker{globals};
+    marker.mark(program);
+    return marker.marked;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include "utils.hpp"
+
+// Let perezoso (--lazy-let), solo en el intérprete de árbol. Las variables
+// de let cuya expresión es pura y cara se guardan como ThunkExpression y se
+// evalúan la primera vez que se leen, o nunca si el cuerpo no las usa. Un
+// análisis de estrictez deja en evaluación inmediata las que el cuerpo usa
+// con seguridad (fuera de las ramas de un if o de las fun), que así no
+// pagan el costo del thunk; las expresiones impuras también siguen en orden.
+extern bool lazy_let_enabled;
+
+// Retorna la cantidad de variables que quedan perezosas
+std::size_t analyze_lazy_lets(Expression& program, const Environment& globals);
@@ -1,10 +1,24 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <variant>
 #include <memory>
+#include <thread>
 #include "expression.hpp"
 #include "utils.hpp"
+#include "scanner.hpp"
+#include "profiler.hpp"
+#include "sampler.hpp"
+#include "trace.hpp"
+#include "stats.hpp"
+#include "closure_compiler.hpp"
+#include "jit.hpp"
+#include "aot.hpp"
+#include "parallel.hpp"
+#include "stack_eval.hpp"
+#include "budget.hpp"
+#include "lazy_let.hpp"
 
 extern FILE* yyin;
 extern int yyparse();
@@ -18,12 +32,14 @@ std::string datatype_to_string(Datatype type) noexcept {
         case Datatype::StringType: return "string";
         case Datatype::BoolType: return "bool";
         case Datatype::PairType: return "pair";
+        case Datatype::TupleType: return "tuple";
         case Datatype::ArrayType: return "array";
         case Datatype::IntArrayType: return "int_array";
         case Datatype::RealArrayType: return "real_array";
         case Datatype::StringArrayType: return "string_array";
         case Datatype::BoolArrayType: return "bool_array";
         case Datatype::FunctionType: return "function";
+        case Datatype::MapType: return "map";
         case Datatype::UnknownType: return "unknown";
         default: return "unknown";
     }
@@ -32,22 +48,182 @@ std::string datatype_to_string(Datatype type) noexcept {
 int main(int argc, char* argv[])
 {
  
-    if (argc == 2) {
-        yyin = fopen(argv[1], "r");
-        if (!yyin)
-        {
-            printf("Could not open %s\n", argv[1]);
+    // Uso: ./main [--profile] [--profile-lines] [--alloc-profile] [--sample salida.folded]
+    //             [--trace salida.json] [--stats] [--stats-json salida.json] [--perf]
+    //             [--backend=tree|closure|stack] [--jit [--jit-threshold llamadas]]
+    //             [--parallel [--parallel-threads hilos]] [--lazy-let] [--max-steps llamadas]
+    //             [--max-time-ms ms] [--max-bytes bytes] [--emit-exe ejecutable] [archivo]
+    const char* input_path = nullptr;
+    const char* sample_path = nullptr;
+    const char* trace_path = nullptr;
+    const char* stats_path = nullptr;
+    const char* executable_path = nullptr;
+    bool perf_requested = false;
+    bool stats_text = false;  // --stats y --stats-json son salidas independientes
+    bool closure_backend = false;
+    bool stack_backend = false;
+    bool parallel_requested = false;
+    bool lazy_let_requested = false;
+    long parallel_threads = std::thread::hardware_concurrency();
+    long sample_interval_us = 1000;
+    EvalBudget budget;
+    int exit_status = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--profile") {
+            profile_enabled = true;
+        } else if (arg == "--profile-lines") {
+            line_profile_enabled = true;
+        } else if (arg == "--alloc-profile") {
+            alloc_profile_enabled = true;
+            allocation_counting = true;
+        } else if (arg == "--sample" && i + 1 < argc) {
+            sample_path = argv[++i];
+        } else if (arg == "--sample-interval" && i + 1 < argc) {
+            sample_interval_us = std::max(1L, atol(argv[++i]));
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+            trace_enabled = true;
+        } else if (arg == "--trace-threshold" && i + 1 < argc) {
+            trace_threshold_ns = std::max(0L, atol(argv[++i])) * 1000;
+        } else if (arg == "--stats") {
+            stats_text = true;
+            stats_enabled = true;
+            allocation_counting = true;
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            stats_path = argv[++i];
+            stats_enabled = true;
+            allocation_counting = true;
+        } else if (arg == "--perf") {
+            // Los contadores se reportan por fase junto con --stats
+            perf_requested = true;
+            stats_text = true;
+            stats_enabled = true;
+            allocation_counting = true;
+        } else if (arg == "--backend=closure") {
+            closure_backend = true;
+            stack_backend = false;
+        } else if (arg == "--backend=tree") {
+            closure_backend = false;
+            stack_backend = false;
+        } else if (arg == "--backend=stack") {
+            // Recursión sin límite de la pila de C++
+            stack_backend = true;
+            closure_backend = false;
+        } else if (arg == "--emit-exe" && i + 1 < argc) {
+            executable_path = argv[++i];
+        } else if (arg == "--jit") {
+            // El JIT reemplaza entradas de la tabla de funciones del backend de closures
+            jit_enabled = true;
+            closure_backend = true;
+            stack_backend = false;
+        } else if (arg == "--jit-threshold" && i + 1 < argc) {
+            jit_threshold = std::max(0L, atol(argv[++i]));
+        } else if (arg == "--max-steps" && i + 1 < argc) {
+            budget.max_steps = std::max(0LL, atoll(argv[++i]));
+        } else if (arg == "--max-time-ms" && i + 1 < argc) {
+            budget.max_time_ms = std::max(0L, atol(argv[++i]));
+        } else if (arg == "--max-bytes" && i + 1 < argc) {
+            budget.max_bytes = std::max(0LL, atoll(argv[++i]));
+        } else if (arg == "--lazy-let") {
+            lazy_let_requested = true;
+        } else if (arg == "--parallel") {
+            parallel_requested = true;
+        } else if (arg == "--parallel-threads" && i + 1 < argc) {
+            parallel_threads = std::max(1L, atol(argv[++i]));
+        } else if (input_path == nullptr) {
+            input_path = argv[i];
+        } else {
+            printf("Usage: %s [--profile] [--profile-lines] [--alloc-profile] [--sample out.folded [--sample-interval us]]"
+                   " [--trace out.json [--trace-threshold us]] [--stats] [--stats-json out.json] [--perf]"
+                   " [--backend=tree|closure|stack] [--jit [--jit-threshold calls]]"
+                   " [--parallel [--parallel-threads n]] [--lazy-let] [--max-steps calls] [--max-time-ms ms] [--max-bytes bytes]"
+                   " [--emit-exe out] [file]\n", argv[0]);
             exit(1);
         }
     }
+    if (perf_requested) {
+        enable_perf_counters();
+    }
+    bool budget_requested = budget.max_steps > 0 || budget.max_time_ms > 0 || budget.max_bytes > 0;
+    if (budget_requested && jit_enabled) {
+        // El código nativo se llama a sí mismo sin pasar por las revisiones
+        fprintf(stderr, "--jit is ignored with --max-steps, --max-time-ms and --max-bytes\n");
+        jit_enabled = false;
+    }
+    if (lazy_let_requested && (closure_backend || stack_backend)) {
+        fprintf(stderr, "--lazy-let only applies to --backend=tree\n");
+        lazy_let_requested = false;
+    }
+    if (stack_backend && (profile_enabled || line_profile_enabled || alloc_profile_enabled || sample_path != nullptr ||
+                          trace_path != nullptr)) {
+        // Los marcos de --backend=stack no abren ProfileScope, SampleScope ni
+        // TraceScope: los reportes saldrían vacíos o atribuidos a main
+        fprintf(stderr, "--profile, --profile-lines, --alloc-profile, --sample and --trace are ignored with --backend=stack\n");
+        profile_enabled = false;
+        line_profile_enabled = false;
+        alloc_profile_enabled = false;
+        sample_path = nullptr;
+        trace_path = nullptr;
+        trace_enabled = false;
+    }
+    if (parallel_requested) {
+        // Los perfiladores y el trazado llevan pilas globales de un solo hilo
+        if (profile_enabled || line_profile_enabled || alloc_profile_enabled || sample_path != nullptr ||
+            trace_path != nullptr) {
+            fprintf(stderr, "--parallel is ignored with --profile, --profile-lines, --alloc-profile, --sample and --trace\n");
+            parallel_requested = false;
+        } else if (closure_backend || stack_backend) {
+            fprintf(stderr, "--parallel only applies to --backend=tree\n");
+            parallel_requested = false;
+        }
+    }
+
+    bool mapped = false;
+    if (input_path != nullptr) {
+        // Preferir el archivo mapeado en memoria; si no se puede, leer con stdio
+        mapped = map_source_file(input_path);
+        if (!mapped) {
+            yyin = fopen(input_path, "r");
+            if (!yyin)
+            {
+                printf("Could not open %s\n", input_path);
+                exit(1);
+            }
+        }
+    }
     
-    int result = yyparse();
+    auto finish_reports = [&] {
+        if (trace_path != nullptr && !write_trace(trace_path)) {
+            fprintf(stderr, "Could not write %s\n", trace_path);
+        }
+        if (stats_path != nullptr) {
+            FILE* stats_file = fopen(stats_path, "w");
+            if (stats_file != nullptr) {
+                print_stats_json(stats_file);
+                fclose(stats_file);
+            } else {
+                fprintf(stderr, "Could not write %s\n", stats_path);
+            }
+        }
+        if (stats_text) {
+            print_stats(stderr);
+        }
+    };
+
+    int result;
+    {
+        TraceScope parse_trace{"phase", "parse"};
+        PhaseScope parse_phase{Phase::Parse};
+        result = yyparse();
+    }
 
     if (result == 0)
         printf("Parse ok!\n");
     else
     {
         printf("Parse failed!\n");
+        finish_reports();
         return 0;
     }
 
@@ -55,28 +231,122 @@ int main(int argc, char* argv[])
         printf("Parsed expression: %s\n", parser_result->to_string().c_str());
         
         printf("Type checking...\n");
-        auto [type_ok, type_result] = parser_result->type_check(global_env);
+        std::pair<bool, Datatype> type_check_result;
+        {
+            TraceScope type_check_trace{"phase", "type check"};
+            PhaseScope type_check_phase{Phase::TypeCheck};
+            type_check_result = parser_result->type_check(global_env);
+        }
+        auto [type_ok, type_result] = type_check_result;
         if (type_ok) {
             printf("Type check passed. Type: %s\n", datatype_to_string(type_result).c_str());
         } else {
             printf("Type check failed...\n");
+            finish_reports();
+            return 0;
+        }
+        if (executable_path != nullptr) {
+            // En lugar de evaluar, generar el ejecutable del programa
+            std::string error;
+            bool built;
+            {
+                TraceScope compile_trace{"phase", "emit executable"};
+                PhaseScope compile_phase{Phase::Compile};
+                built = emit_executable(*parser_result, global_env, executable_path, error);
+            }
+            if (built) {
+                printf("Executable written to %s\n", executable_path);
+            } else {
+                printf("Could not build %s: %s\n", executable_path, error.c_str());
+            }
+            finish_reports();
             return 0;
         }
         try {
             printf("Evaluating expression...\n");
+            if (sample_path != nullptr) {
+                sampling_enabled = start_sampling(sample_interval_us);
+                if (!sampling_enabled) {
+                    fprintf(stderr, "Could not start the sampling profiler\n");
+                }
+            }
             // Usar el entorno global que contiene las funciones definidas
-            auto result = parser_result->eval(global_env);
-            printf("Result: %s\n", result->to_string().c_str());
+            std::shared_ptr<Expression> value;
+            start_budget(budget);
+            if (closure_backend) {
+                std::unique_ptr<CompiledProgram> program;
+                {
+                    TraceScope compile_trace{"phase", "compile"};
+                    PhaseScope compile_phase{Phase::Compile};
+                    program = compile_program(*parser_result, global_env);
+                }
+                TraceScope eval_trace{"statement", "eval"};
+                PhaseScope eval_phase{Phase::Eval};
+                value = program->run();
+            } else if (stack_backend) {
+                TraceScope eval_trace{"statement", "eval"};
+                PhaseScope eval_phase{Phase::Eval};
+                value = eval_with_stack(*parser_result, global_env);
+            } else {
+                if (lazy_let_requested) {
+                    TraceScope analyze_trace{"phase", "strictness analysis"};
+                    PhaseScope compile_phase{Phase::Compile};
+                    analyze_lazy_lets(*parser_result, global_env);
+                    lazy_let_enabled = true;
+                }
+                if (parallel_requested) {
+                    TraceScope analyze_trace{"phase", "parallelism analysis"};
+                    PhaseScope compile_phase{Phase::Compile};
+                    analyze_parallelism(*parser_result, global_env);
+                    start_parallel(parallel_threads);
+                }
+                TraceScope eval_trace{"statement", "eval"};
+                PhaseScope eval_phase{Phase::Eval};
+                try {
+                    value = parser_result->eval(global_env);
+                } catch (...) {
+                    stop_parallel();
+                    throw;
+                }
+                stop_parallel();
+            }
+            stop_budget();
+            printf("Result: %s\n", value->to_string().c_str());
+        } catch (const BudgetExceeded& e) {
+            // Distinto de un error del programa: se cortó por el presupuesto
+            stop_budget();
+            printf("Evaluation aborted: %s\n", e.what());
+            exit_status = 2;
         } catch (const std::exception& e) {
+            stop_budget();
             printf("Evaluation error: %s\n", e.what());
         }
+        if (sampling_enabled) {
+            stop_sampling();
+            sampling_enabled = false;
+            if (!write_folded_stacks(sample_path)) {
+                fprintf(stderr, "Could not write %s\n", sample_path);
+            }
+        }
+        if (profile_enabled) {
+            print_profile_report(stderr);
+        }
+        if (line_profile_enabled) {
+            print_line_profile_report(stderr, input_path);
+        }
+        if (alloc_profile_enabled) {
+            print_allocation_report(stderr);
+        }
+        finish_reports();
         
        
     } else {
         printf("No expression parsed\n");
     }
-    if (argc == 2) {
+    if (mapped) {
+        unmap_source_file();
+    } else if (input_path != nullptr) {
         fclose(yyin);
     }
-    return 0;
+    return exit_status;
 }
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "parallel.hpp"
+#include "expression.hpp"
+#include "purity.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool parallel_enabled = false;
+
+namespace {
+
+// Operando derecho publicado por fork_join (o trabajo de parallel_invoke,
+// si job no es nulo). Vive en la pila de quien lo publica, que no retorna
+// hasta que done esté en true.
+struct Task {
+    const Expression* expression = nullptr;
+    Environment* env = nullptr;
+    const std::function<void()>* job = nullptr;
+    std::shared_ptr<Expression> result;
+    std::exception_ptr error;
+    std::atomic<bool> done{false};
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::deque<Task*> tasks;
+    std::atomic<std::size_t> size{0};
+};
+
+// Con esta cantidad de tareas sin robar en la cola propia ya no se publican
+// más: los demás hilos tienen trabajo de sobra
+constexpr std::size_t kSpawnLimit = 2;
+
+std::vector<std::unique_ptr<Worker>> workers;
+std::vector<std::thread> threads;
+std::atomic<bool> stopping{false};
+std::atomic<std::size_t> queued{0};
+std::atomic<unsigned> sleeping{0};
+std::mutex sleep_mutex;
+std::condition_variable wake;
+
+thread_local std::size_t worker_id = 0;
+
+void run_task(Task& task) noexcept
+{
+    try {
+        if (task.job) {
+            (*task.job)();
+        } else {
+            task.result = task.expression->eval(*task.env);
+        }
+    } catch (...) {
+        task.error = std::current_exception();
+    }
+    task.done.store(true, std::memory_order_release);
+}
+
+void push_task(Task& task)
+{
+    auto& worker = *workers[worker_id];
+    {
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        worker.tasks.push_back(&task);
+        worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+    }
+    queued.fetch_add(1);
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        wake.notify_one();
+    }
+}
+
+// Retira task de la cola propia si nadie la robó. Por el anidamiento de
+// fork_join, si sigue en la cola es la última.
+bool take_back(Task& task)
+{
+    auto& worker = *workers[worker_id];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    if (worker.tasks.empty() || worker.tasks.back() != &task) {
+        return false;
+    }
+    worker.tasks.pop_back();
+    worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+    queued.fetch_sub(1);
+    return true;
+}
+
+// Primero la cola propia (lo más reciente), después la más antigua de
+// las demás colas (las tareas más grandes)
+Task* find_task()
+{
+    std::size_t count = workers.size();
+    for (std::size_t offset = 0; offset < count; ++offset) {
+        auto& worker = *workers[(worker_id + offset) % count];
+        if (worker.size.load(std::memory_order_relaxed) == 0) continue;
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (worker.tasks.empty()) continue;
+        Task* task;
+        if (offset == 0) {
+            task = worker.tasks.back();
+            worker.tasks.pop_back();
+        } else {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+        }
+        worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+        queued.fetch_sub(1);
+        return task;
+    }
+    return nullptr;
+}
+
+// Mientras otro hilo evalúa la tarea robada, ayudar con otras
+void wait_for(Task& task)
+{
+    while (!task.done.load(std::memory_order_acquire)) {
+        if (Task* other = find_task()) {
+            run_task(*other);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void worker_loop(std::size_t id)
+{
+    worker_id = id;
+    while (!stopping.load()) {
+        if (Task* task = find_task()) {
+            run_task(*task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{sleep_mutex};
+        sleeping.fetch_add(1);
+        wake.wait(lock, [] { return stopping.load() || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+    }
+}
+
+// Marca las expresiones binarias con los dos operandos puros y caros
+class ParallelMarker : public PurityAnalyzer
+{
+public:
+    using PurityAnalyzer::PurityAnalyzer;
+
+    std::size_t marked = 0;
+
+protected:
+    void on_binary(BinaryExpression& node, PuritySummary left, PuritySummary right) override
+    {
+        if (left.pure && right.pure && left.expensive && right.expensive) {
+            node.set_parallel(true);
+            ++marked;
+        }
+    }
+};
+
+} // namespace
+
+void start_parallel(unsigned count)
+{
+    stopping = false;
+    workers.clear();
+    for (unsigned i = 0; i < std::max(count, 1u); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    worker_id = 0;
+    for (unsigned i = 1; i < count; ++i) {
+        threads.emplace_back(worker_loop, i);
+    }
+    parallel_enabled = count > 1;
+}
+
+void stop_parallel()
+{
+    parallel_enabled = false;
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        stopping = true;
+        wake.notify_all();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    workers.clear();
+}
+
+std::size_t analyze_parallelism(Expression& program, const Environment& globals)
+{
+    ParallelMarker marker{globals};
+    marker.mark(program);
+    return marker.marked;
+}
+
+std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>
+fork_join(const Expression& left, const Expression& right, Environment& env)
+{
+    if (workers[worker_id]->size.load(std::memory_order_relaxed) >= kSpawnLimit) {
+        auto left_value = left.eval(env);
+        return {left_value, right.eval(env)};
+    }
+    Task task;
+    task.expression = &right;
+    task.env = &env;
+    push_task(task);
+
+    std::shared_ptr<Expression> left_value;
+    try {
+        left_value = left.eval(env);
+    } catch (...) {
+        // El derecho no llega a evaluarse si nadie lo robó todavía
+        if (!take_back(task)) {
+            wait_for(task);
+        }
+        throw;
+    }
+    if (take_back(task)) {
+        run_task(task);
+    } else {
+        wait_for(task);
+    }
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
+    return {left_value, task.result};
+}
+
+void parallel_invoke(const std::function<void()>& left, const std::function<void()>& right)
+{
+    if (!parallel_enabled || workers[worker_id]->size.load(std::memory_order_relaxed) >= kSpawnLimit) {
+        left();
+        right();
+        return;
+    }
+    Task task;
+    task.job = &right;
+    push_task(task);
+
+    try {
+        left();
+    } catch (...) {
+        if (!take_back(task)) {
+            wait_for(task);
+        }
+        throw;
+    }
+    if (take_back(task)) {
+        run_task(task);
+    } else {
+        wait_for(task);
+    }
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include "utils.hpp"
+
+// Paralelismo fork-join automático (--parallel), solo en el intérprete de
+// árbol. analyze_parallelism marca las expresiones binarias cuyos dos
+// operandos son puros (sin print, asignaciones ni fun anidadas, y que solo
+// llaman funciones globales puras) y caros (contienen alguna llamada). Al
+// evaluarlas, el operando derecho se publica como tarea en la cola del hilo
+// y el izquierdo se evalúa en el mismo hilo; los hilos libres roban tareas
+// de las colas de los demás. Para no pagar el costo de una tarea por cada
+// nodo, solo se publica cuando la cola propia está casi vacía (lazy binary
+// splitting): si ya hay trabajo esperando a ser robado, el nodo se evalúa en
+// secuencia.
+extern bool parallel_enabled;
+
+// workers incluye al hilo que llama (worker 0). Con menos de 2 no se crean
+// hilos y las expresiones marcadas se evalúan en secuencia.
+void start_parallel(unsigned workers);
+
+void stop_parallel();
+
+// Retorna la cantidad de expresiones marcadas
+std::size_t analyze_parallelism(Expression& program, const Environment& globals);
+
+// Evalúa left y right (posiblemente en paralelo) y retorna ambos valores.
+// Si alguno lanza una excepción se espera al otro y se relanza la de left
+// antes que la de right, como en la evaluación secuencial.
+std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>
+fork_join(const Expression& left, const Expression& right, Environment& env);
+
+// Como fork_join, para trabajo que no es una expresión (por ejemplo las
+// mitades de sort). Sin --parallel corre left y después right.
+void parallel_invoke(const std::function<void()>& left, const std::function<void()>& right);
@@ -0,0 +1,202 @@
+#include "perf_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounts PerfCounts::operator-(const PerfCounts& other) const noexcept
+{
+    PerfCounts result;
+    for (int i = 0; i < PerfEventCount; ++i) {
+        result.present[i] = present[i] && other.present[i];
+        result.values[i] = result.present[i] ? values[i] - other.values[i] : 0;
+    }
+    return result;
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) noexcept
+{
+    for (int i = 0; i < PerfEventCount; ++i) {
+        present[i] = present[i] || other.present[i];
+        values[i] += other.values[i];
+    }
+    return *this;
+}
+
+double PerfCounts::ipc() const noexcept
+{
+    if (!present[PerfCycles] || !present[PerfInstructions] || values[PerfCycles] == 0) {
+        return -1.0;
+    }
+    return static_cast<double>(values[PerfInstructions]) / values[PerfCycles];
+}
+
+double PerfCounts::per_kilo_instruction(PerfEvent event) const noexcept
+{
+    if (!present[event] || !present[PerfInstructions] || values[PerfInstructions] == 0) {
+        return -1.0;
+    }
+    return 1000.0 * values[event] / values[PerfInstructions];
+}
+
+const char* perf_event_name(PerfEvent event) noexcept
+{
+    switch (event) {
+        case PerfCycles: return "cycles";
+        case PerfInstructions: return "instructions";
+        case PerfL1dMisses: return "l1d_misses";
+        case PerfLlcMisses: return "llc_misses";
+        case PerfBranchMisses: return "branch_misses";
+        default: return "unknown";
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+bool PerfCounters::is_open() const noexcept
+{
+    return leader_fd >= 0;
+}
+
+const std::string& PerfCounters::error() const noexcept
+{
+    return last_error;
+}
+
+#ifdef __linux__
+
+namespace {
+
+void describe_event(PerfEvent event, perf_event_attr& attr) noexcept
+{
+    constexpr auto cache_read_miss = [](std::uint64_t cache) {
+        return cache
+            | (static_cast<std::uint64_t>(PERF_COUNT_HW_CACHE_OP_READ) << 8)
+            | (static_cast<std::uint64_t>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+    };
+    switch (event) {
+        case PerfCycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfInstructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfL1dMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_read_miss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case PerfLlcMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_read_miss(PERF_COUNT_HW_CACHE_LL);
+            break;
+        case PerfBranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+bool PerfCounters::open() noexcept
+{
+    close();
+    // Todos los eventos van en un grupo para que se lean juntos; los que el
+    // procesador no soporta simplemente quedan fuera
+    for (int i = 0; i < PerfEventCount; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        describe_event(static_cast<PerfEvent>(i), attr);
+        attr.disabled = leader_fd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_fd, 0));
+        if (fd < 0) {
+            if (last_error.empty()) {
+                last_error = std::string{perf_event_name(static_cast<PerfEvent>(i))} + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+        if (leader_fd < 0) {
+            leader_fd = fd;
+        }
+        fds[i] = fd;
+        group_index[i] = group_size++;
+    }
+    if (leader_fd < 0) {
+        return false;
+    }
+    ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close() noexcept
+{
+    for (int i = 0; i < PerfEventCount; ++i) {
+        if (fds[i] >= 0) {
+            ::close(fds[i]);
+        }
+        fds[i] = -1;
+        group_index[i] = -1;
+    }
+    leader_fd = -1;
+    group_size = 0;
+}
+
+PerfCounts PerfCounters::read() const noexcept
+{
+    PerfCounts counts;
+    if (leader_fd < 0) {
+        return counts;
+    }
+    // Formato: nr, time_enabled, time_running, values[nr]
+    std::uint64_t buffer[3 + PerfEventCount];
+    if (::read(leader_fd, buffer, sizeof buffer) < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) {
+        return counts;
+    }
+    std::uint64_t enabled = buffer[1];
+    std::uint64_t running = buffer[2];
+    double scale = running > 0 && running < enabled ? static_cast<double>(enabled) / running : 1.0;
+    for (int i = 0; i < PerfEventCount; ++i) {
+        if (group_index[i] < 0 || static_cast<std::uint64_t>(group_index[i]) >= buffer[0]) continue;
+        counts.present[i] = running > 0;
+        counts.values[i] = static_cast<std::uint64_t>(buffer[3 + group_index[i]] * scale);
+    }
+    return counts;
+}
+
+#else
+
+bool PerfCounters::open() noexcept
+{
+    last_error = "perf_event_open is only available on Linux";
+    return false;
+}
+
+void PerfCounters::close() noexcept
+{
+}
+
+PerfCounts PerfCounters::read() const noexcept
+{
+    return {};
+}
+
+#endif
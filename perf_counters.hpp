@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Contadores de hardware vía perf_event_open (solo Linux). Si el kernel no
+// los ofrece (otro sistema, máquina virtual, perf_event_paranoid) open()
+// retorna false y quien los usa sigue sin ellos.
+enum PerfEvent {
+    PerfCycles,
+    PerfInstructions,
+    PerfL1dMisses,
+    PerfLlcMisses,
+    PerfBranchMisses,
+    PerfEventCount
+};
+
+struct PerfCounts {
+    std::uint64_t values[PerfEventCount] = {};
+    bool present[PerfEventCount] = {};
+
+    PerfCounts operator-(const PerfCounts& other) const noexcept;
+    PerfCounts& operator+=(const PerfCounts& other) noexcept;
+
+    double ipc() const noexcept;
+    // Eventos por cada mil instrucciones; -1 si falta alguno de los dos contadores
+    double per_kilo_instruction(PerfEvent event) const noexcept;
+};
+
+const char* perf_event_name(PerfEvent event) noexcept;
+
+class PerfCounters
+{
+public:
+    PerfCounters() noexcept = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Abre los contadores del proceso actual (solo espacio de usuario)
+    bool open() noexcept;
+
+    void close() noexcept;
+
+    bool is_open() const noexcept;
+
+    // Valores acumulados desde open(), escalados si el kernel multiplexó
+    PerfCounts read() const noexcept;
+
+    // Motivo del último fallo de open()
+    const std::string& error() const noexcept;
+
+private:
+    int leader_fd = -1;
+    int fds[PerfEventCount] = {-1, -1, -1, -1, -1};
+    int group_index[PerfEventCount] = {-1, -1, -1, -1, -1};
+    int group_size = 0;
+    std::string last_error;
+};
@@ -0,0 +1,191 @@
+#include "persistent_map.hpp"
+#include "expression.hpp"
+
+#include <bitset>
+
+namespace {
+
+constexpr unsigned kBits = 5;
+constexpr std::uint64_t kMask = (1u << kBits) - 1;
+// Desde aquí ya no quedan bits del hash: nodo de colisión con lista simple
+constexpr unsigned kHashBits = 64;
+
+std::uint32_t bit_for(std::uint64_t hash, unsigned shift) noexcept
+{
+    return 1u << ((hash >> shift) & kMask);
+}
+
+std::size_t index_for(std::uint32_t bitmap, std::uint32_t bit) noexcept
+{
+    return std::bitset<32>(bitmap & (bit - 1)).count();
+}
+
+} // namespace
+
+std::size_t PersistentMap::size() const noexcept
+{
+    return count;
+}
+
+const PersistentMap::Value* PersistentMap::find(const Expression& key) const noexcept
+{
+    std::uint64_t hash = hash_value(key);
+    const Node* node = root.get();
+    for (unsigned shift = 0; node != nullptr; shift += kBits) {
+        if (shift >= kHashBits) {
+            for (const auto& slot : node->slots) {
+                if (equal_values(*slot.key, key)) return &slot.value;
+            }
+            return nullptr;
+        }
+        std::uint32_t bit = bit_for(hash, shift);
+        if ((node->bitmap & bit) == 0) return nullptr;
+        const Slot& slot = node->slots[index_for(node->bitmap, bit)];
+        if (!slot.child) {
+            return slot.hash == hash && equal_values(*slot.key, key) ? &slot.value : nullptr;
+        }
+        node = slot.child.get();
+    }
+    return nullptr;
+}
+
+PersistentMap PersistentMap::insert(Value key, Value value) const
+{
+    Slot entry;
+    entry.hash = hash_value(*key);
+    entry.key = std::move(key);
+    entry.value = std::move(value);
+    bool added = false;
+    PersistentMap result;
+    result.root = insert_in(root, 0, std::move(entry), added);
+    result.count = count + (added ? 1 : 0);
+    return result;
+}
+
+PersistentMap PersistentMap::erase(const Expression& key) const
+{
+    bool removed = false;
+    auto new_root = erase_in(root, 0, hash_value(key), key, removed);
+    if (!removed) return *this;
+    PersistentMap result;
+    result.root = std::move(new_root);
+    result.count = count - 1;
+    return result;
+}
+
+std::shared_ptr<const PersistentMap::Node> PersistentMap::insert_in(const std::shared_ptr<const Node>& node,
+                                                                    unsigned shift, Slot entry, bool& added)
+{
+    if (!node) {
+        auto created = std::make_shared<Node>();
+        created->bitmap = shift >= kHashBits ? 0 : bit_for(entry.hash, shift);
+        created->slots.push_back(std::move(entry));
+        added = true;
+        return created;
+    }
+    auto copy = std::make_shared<Node>(*node);
+    if (shift >= kHashBits) {
+        for (auto& slot : copy->slots) {
+            if (equal_values(*slot.key, *entry.key)) {
+                slot.value = std::move(entry.value);
+                return copy;
+            }
+        }
+        copy->slots.push_back(std::move(entry));
+        added = true;
+        return copy;
+    }
+    std::uint32_t bit = bit_for(entry.hash, shift);
+    std::size_t index = index_for(copy->bitmap, bit);
+    if ((copy->bitmap & bit) == 0) {
+        copy->bitmap |= bit;
+        copy->slots.insert(copy->slots.begin() + index, std::move(entry));
+        added = true;
+        return copy;
+    }
+    Slot& slot = copy->slots[index];
+    if (slot.child) {
+        slot.child = insert_in(slot.child, shift + kBits, std::move(entry), added);
+    } else if (slot.hash == entry.hash && equal_values(*slot.key, *entry.key)) {
+        slot.value = std::move(entry.value);
+    } else {
+        Slot existing = std::move(slot);
+        slot = Slot{};
+        slot.child = merge(std::move(existing), std::move(entry), shift + kBits);
+        added = true;
+    }
+    return copy;
+}
+
+std::shared_ptr<const PersistentMap::Node> PersistentMap::merge(Slot first, Slot second, unsigned shift)
+{
+    auto node = std::make_shared<Node>();
+    if (shift >= kHashBits) {
+        node->slots.push_back(std::move(first));
+        node->slots.push_back(std::move(second));
+        return node;
+    }
+    std::uint32_t first_bit = bit_for(first.hash, shift);
+    std::uint32_t second_bit = bit_for(second.hash, shift);
+    if (first_bit == second_bit) {
+        node->bitmap = first_bit;
+        Slot slot;
+        slot.child = merge(std::move(first), std::move(second), shift + kBits);
+        node->slots.push_back(std::move(slot));
+        return node;
+    }
+    node->bitmap = first_bit | second_bit;
+    if (first_bit < second_bit) {
+        node->slots.push_back(std::move(first));
+        node->slots.push_back(std::move(second));
+    } else {
+        node->slots.push_back(std::move(second));
+        node->slots.push_back(std::move(first));
+    }
+    return node;
+}
+
+std::shared_ptr<const PersistentMap::Node> PersistentMap::erase_in(const std::shared_ptr<const Node>& node,
+                                                                   unsigned shift, std::uint64_t hash,
+                                                                   const Expression& key, bool& removed)
+{
+    if (!node) return node;
+    if (shift >= kHashBits) {
+        for (std::size_t i = 0; i < node->slots.size(); ++i) {
+            if (!equal_values(*node->slots[i].key, key)) continue;
+            removed = true;
+            if (node->slots.size() == 1) return nullptr;
+            auto copy = std::make_shared<Node>(*node);
+            copy->slots.erase(copy->slots.begin() + i);
+            return copy;
+        }
+        return node;
+    }
+    std::uint32_t bit = bit_for(hash, shift);
+    if ((node->bitmap & bit) == 0) return node;
+    std::size_t index = index_for(node->bitmap, bit);
+    const Slot& slot = node->slots[index];
+
+    std::shared_ptr<const Node> new_child;
+    if (slot.child) {
+        new_child = erase_in(slot.child, shift + kBits, hash, key, removed);
+        if (!removed) return node;
+    } else if (slot.hash == hash && equal_values(*slot.key, key)) {
+        removed = true;
+    } else {
+        return node;
+    }
+
+    auto copy = std::make_shared<Node>(*node);
+    if (new_child && (new_child->slots.size() > 1 || new_child->slots.front().child)) {
+        copy->slots[index].child = new_child;
+    } else if (new_child) {
+        // Subnodo con una sola entrada: la entrada sube a este nodo
+        copy->slots[index] = new_child->slots.front();
+    } else {
+        copy->bitmap &= ~bit;
+        copy->slots.erase(copy->slots.begin() + index);
+        if (copy->slots.empty()) return nullptr;
+    }
+    return copy;
+}
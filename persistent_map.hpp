@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "utils.hpp"
+#include "value_equality.hpp"
+
+// Map inmutable (hash array mapped trie). Cada nodo usa 5 bits del hash y
+// guarda solo las entradas presentes, empacadas según un bitmap: sin
+// casillas vacías ni marcas de borrado. insert y erase copian solo los
+// nodos del camino a la llave (a lo más 13) y comparten el resto con el map
+// original, así que los dos siguen siendo válidos.
+class PersistentMap
+{
+public:
+    using Value = std::shared_ptr<Expression>;
+
+    std::size_t size() const noexcept;
+
+    // nullptr si la llave no está
+    const Value* find(const Expression& key) const noexcept;
+
+    PersistentMap insert(Value key, Value value) const;
+
+    PersistentMap erase(const Expression& key) const;
+
+    // Recorre las entradas en el orden del trie (fijo para un mismo
+    // conjunto de llaves)
+    template <typename Visitor>
+    void for_each(Visitor visit) const
+    {
+        if (root) for_each_in(*root, visit);
+    }
+
+private:
+    struct Node;
+
+    struct Slot {
+        std::uint64_t hash = 0;
+        Value key;
+        Value value;
+        std::shared_ptr<const Node> child;  // si no es nulo, la casilla es un subnodo
+    };
+
+    struct Node {
+        std::uint32_t bitmap = 0;  // sin uso en los nodos de colisión
+        std::vector<Slot> slots;
+    };
+
+    template <typename Visitor>
+    static void for_each_in(const Node& node, Visitor& visit)
+    {
+        for (const auto& slot : node.slots) {
+            if (slot.child) {
+                for_each_in(*slot.child, visit);
+            } else {
+                visit(slot.key, slot.value);
+            }
+        }
+    }
+
+    static std::shared_ptr<const Node> insert_in(const std::shared_ptr<const Node>& node, unsigned shift, Slot entry,
+                                                 bool& added);
+
+    static std::shared_ptr<const Node> erase_in(const std::shared_ptr<const Node>& node, unsigned shift,
+                                                std::uint64_t hash, const Expression& key, bool& removed);
+
+    static std::shared_ptr<const Node> merge(Slot first, Slot second, unsigned shift);
+
+    std::shared_ptr<const Node> root;
+    std::size_t count = 0;
+};
@@ -0,0 +1,383 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+bool profile_enabled = false;
+bool alloc_profile_enabled = false;
+bool allocation_counting = false;
+bool line_profile_enabled = false;
+
+namespace {
+
+struct ProfileEntry {
+    std::string name;
+    std::uint64_t calls = 0;
+    std::int64_t inclusive_ns = 0;
+    std::int64_t exclusive_ns = 0;
+    int depth = 0;  // activaciones abiertas; evita contar dos veces la recursión
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+};
+
+struct ProfileFrame {
+    ProfileEntry* entry;
+    std::int64_t start_ns;
+    std::int64_t children_ns;
+    std::uint32_t line;
+};
+
+struct LineEntry {
+    std::uint64_t evals = 0;
+    std::int64_t self_ns = 0;
+};
+
+// Los nodos y las funciones llevan pilas separadas: el tiempo exclusivo de una
+// función es el de su cuerpo menos el de las funciones que llama.
+std::unordered_map<const std::type_info*, ProfileEntry> node_entries;
+std::unordered_map<std::string, ProfileEntry> function_entries;
+std::vector<ProfileFrame> node_stack;
+std::vector<ProfileFrame> function_stack;
+std::map<std::uint32_t, LineEntry> line_entries;
+
+// Destino de las asignaciones hechas fuera de todo eval o de toda función
+ProfileEntry outside_eval{"<outside eval>"};
+ProfileEntry top_level{"<top level>"};
+
+// Atómicos: con --parallel varios hilos asignan memoria a la vez
+struct AllocationTotals {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> live_bytes{0};
+    std::atomic<std::uint64_t> peak_live_bytes{0};
+    std::atomic<std::uint64_t> unattributed{0};  // hechas por el propio perfilador
+
+    void reset() noexcept
+    {
+        allocations = frees = bytes = live_bytes = peak_live_bytes = unattributed = 0;
+    }
+};
+
+AllocationTotals allocation_totals;
+
+// Mientras el perfilador actualiza sus tablas (que también asignan memoria)
+// las asignaciones no se atribuyen a ningún contexto
+bool profiler_busy = false;
+
+std::int64_t now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string demangle(const char* name)
+{
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled{
+        abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free};
+    return status == 0 && demangled ? demangled.get() : name;
+}
+
+// Con solo --alloc-profile no hace falta leer el reloj
+bool timing_enabled() noexcept
+{
+    return profile_enabled || line_profile_enabled;
+}
+
+void enter(std::vector<ProfileFrame>& stack, ProfileEntry& entry, std::uint32_t line) noexcept
+{
+    ++entry.calls;
+    ++entry.depth;
+    stack.push_back({&entry, timing_enabled() ? now_ns() : 0, 0, line});
+}
+
+void leave(std::vector<ProfileFrame>& stack, bool nodes) noexcept
+{
+    if (stack.empty()) return;
+    ProfileFrame frame = stack.back();
+    stack.pop_back();
+    std::int64_t elapsed = timing_enabled() ? now_ns() - frame.start_ns : 0;
+    frame.entry->exclusive_ns += elapsed - frame.children_ns;
+    if (nodes && line_profile_enabled) {
+        auto& line = line_entries[frame.line];
+        ++line.evals;
+        line.self_ns += elapsed - frame.children_ns;
+    }
+    if (--frame.entry->depth == 0) {
+        frame.entry->inclusive_ns += elapsed;
+    }
+    if (!stack.empty()) {
+        stack.back().children_ns += elapsed;
+    }
+}
+
+void print_section(FILE* out, const char* title, std::vector<const ProfileEntry*> entries)
+{
+    std::sort(entries.begin(), entries.end(), [](auto a, auto b) {
+        return a->exclusive_ns > b->exclusive_ns;
+    });
+    std::int64_t total = 0;
+    for (auto entry : entries) total += entry->exclusive_ns;
+
+    fprintf(out, "\n%s\n", title);
+    fprintf(out, "%7s %12s %12s %12s %12s  %s\n",
+            "%excl", "calls", "excl ms", "incl ms", "excl ns/call", "name");
+    for (auto entry : entries) {
+        double percent = total > 0 ? 100.0 * entry->exclusive_ns / total : 0.0;
+        fprintf(out, "%6.2f%% %12llu %12.3f %12.3f %12.0f  %s\n",
+                percent,
+                static_cast<unsigned long long>(entry->calls),
+                entry->exclusive_ns / 1e6,
+                entry->inclusive_ns / 1e6,
+                entry->calls > 0 ? static_cast<double>(entry->exclusive_ns) / entry->calls : 0.0,
+                entry->name.c_str());
+    }
+}
+
+void print_allocation_section(FILE* out, const char* title, std::vector<const ProfileEntry*> entries)
+{
+    constexpr std::size_t top = 15;
+    std::sort(entries.begin(), entries.end(), [](auto a, auto b) {
+        return a->allocated_bytes > b->allocated_bytes;
+    });
+
+    fprintf(out, "\n%s\n", title);
+    fprintf(out, "%14s %14s %10s  %s\n", "allocations", "bytes", "bytes/call", "name");
+    for (std::size_t i = 0; i < entries.size() && i < top; ++i) {
+        auto entry = entries[i];
+        if (entry->allocations == 0) break;
+        fprintf(out, "%14llu %14llu %10.1f  %s\n",
+                static_cast<unsigned long long>(entry->allocations),
+                static_cast<unsigned long long>(entry->allocated_bytes),
+                entry->calls > 0 ? static_cast<double>(entry->allocated_bytes) / entry->calls : 0.0,
+                entry->name.c_str());
+    }
+}
+
+void record_allocation(void* ptr) noexcept
+{
+    std::size_t size = malloc_usable_size(ptr);
+    auto& totals = allocation_totals;
+    totals.allocations.fetch_add(1, std::memory_order_relaxed);
+    totals.bytes.fetch_add(size, std::memory_order_relaxed);
+    std::uint64_t live = totals.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = totals.peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !totals.peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        // peak se actualizó con el valor actual; reintentar
+    }
+
+    if (!alloc_profile_enabled) {
+        return;
+    }
+    if (profiler_busy) {
+        ++totals.unattributed;
+        return;
+    }
+    ProfileEntry& node = node_stack.empty() ? outside_eval : *node_stack.back().entry;
+    ProfileEntry& function = function_stack.empty() ? top_level : *function_stack.back().entry;
+    ++node.allocations;
+    node.allocated_bytes += size;
+    ++function.allocations;
+    function.allocated_bytes += size;
+}
+
+void record_free(void* ptr) noexcept
+{
+    std::size_t size = malloc_usable_size(ptr);
+    auto& totals = allocation_totals;
+    totals.frees.fetch_add(1, std::memory_order_relaxed);
+    // Los bloques asignados antes de activar la bandera no se contaron
+    std::uint64_t live = totals.live_bytes.load(std::memory_order_relaxed);
+    while (!totals.live_bytes.compare_exchange_weak(live, live - std::min<std::uint64_t>(live, size),
+                                                    std::memory_order_relaxed)) {
+        // live se actualizó con el valor actual; reintentar
+    }
+}
+
+void* allocate(std::size_t size)
+{
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    if (allocation_counting) {
+        record_allocation(ptr);
+    }
+    return ptr;
+}
+
+void deallocate(void* ptr) noexcept
+{
+    if (ptr == nullptr) return;
+    if (allocation_counting) {
+        record_free(ptr);
+    }
+    std::free(ptr);
+}
+
+} // namespace
+
+void profile_enter_node(const std::type_info& type, std::uint32_t line) noexcept
+{
+    profiler_busy = true;
+    auto& entry = node_entries[&type];
+    if (entry.name.empty()) {
+        entry.name = demangle(type.name());
+    }
+    enter(node_stack, entry, line);
+    profiler_busy = false;
+}
+
+void profile_enter_function(const std::string& name) noexcept
+{
+    profiler_busy = true;
+    auto& entry = function_entries[name];
+    if (entry.name.empty()) {
+        entry.name = name;
+    }
+    enter(function_stack, entry, 0);
+    profiler_busy = false;
+}
+
+void profile_leave_node() noexcept
+{
+    profiler_busy = true;
+    leave(node_stack, true);
+    profiler_busy = false;
+}
+
+void profile_leave_function() noexcept
+{
+    leave(function_stack, false);
+}
+
+void print_profile_report(FILE* out)
+{
+    std::vector<const ProfileEntry*> nodes;
+    for (const auto& [type, entry] : node_entries) nodes.push_back(&entry);
+    std::vector<const ProfileEntry*> functions;
+    for (const auto& [name, entry] : function_entries) functions.push_back(&entry);
+
+    fprintf(out, "\n=== Flat profile ===\n");
+    print_section(out, "Expression nodes (eval):", std::move(nodes));
+    if (!functions.empty()) {
+        print_section(out, "User functions:", std::move(functions));
+    }
+}
+
+AllocationCount allocation_count() noexcept
+{
+    return {allocation_totals.allocations, allocation_totals.bytes};
+}
+
+std::uint64_t live_allocated_bytes() noexcept
+{
+    return allocation_totals.live_bytes.load(std::memory_order_relaxed);
+}
+
+void print_allocation_report(FILE* out)
+{
+    std::vector<const ProfileEntry*> nodes{&outside_eval};
+    for (const auto& [type, entry] : node_entries) nodes.push_back(&entry);
+    std::vector<const ProfileEntry*> functions{&top_level};
+    for (const auto& [name, entry] : function_entries) functions.push_back(&entry);
+
+    const auto& totals = allocation_totals;
+    fprintf(out, "\n=== Allocation profile ===\n");
+    fprintf(out, "allocations: %llu, frees: %llu, bytes: %llu, peak live bytes: %llu\n",
+            static_cast<unsigned long long>(totals.allocations),
+            static_cast<unsigned long long>(totals.frees),
+            static_cast<unsigned long long>(totals.bytes),
+            static_cast<unsigned long long>(totals.peak_live_bytes));
+    if (totals.unattributed > 0) {
+        fprintf(out, "profiler bookkeeping: %llu allocations (not attributed)\n",
+                static_cast<unsigned long long>(totals.unattributed));
+    }
+    print_allocation_section(out, "By node type:", std::move(nodes));
+    print_allocation_section(out, "By user function:", std::move(functions));
+}
+
+void print_line_profile_report(FILE* out, const char* source_path)
+{
+    std::vector<std::string> source_lines;
+    if (source_path != nullptr) {
+        std::ifstream source{source_path};
+        std::string text;
+        while (std::getline(source, text)) {
+            source_lines.push_back(text);
+        }
+    }
+
+    std::int64_t total = 0;
+    for (const auto& [line, entry] : line_entries) total += entry.self_ns;
+
+    fprintf(out, "\n=== Line profile ===\n");
+    fprintf(out, "%6s %7s %12s %12s  %s\n", "line", "%self", "evals", "self ms", "source");
+    for (const auto& [line, entry] : line_entries) {
+        double percent = total > 0 ? 100.0 * entry.self_ns / total : 0.0;
+        std::string text = line == 0 ? "<no source line>"
+            : line <= source_lines.size() ? source_lines[line - 1] : "";
+        if (text.size() > 60) {
+            text = text.substr(0, 57) + "...";
+        }
+        fprintf(out, "%6u %6.2f%% %12llu %12.3f  %s\n",
+                static_cast<unsigned>(line), percent,
+                static_cast<unsigned long long>(entry.evals),
+                entry.self_ns / 1e6, text.c_str());
+    }
+}
+
+void reset_profile() noexcept
+{
+    line_entries.clear();
+    allocation_totals.reset();
+    outside_eval.allocations = outside_eval.allocated_bytes = 0;
+    top_level.allocations = top_level.allocated_bytes = 0;
+    node_entries.clear();
+    function_entries.clear();
+    node_stack.clear();
+    function_stack.clear();
+}
+
+// Reemplazo global de operator new/delete. Sin contabilidad activa solo
+// agregan una comparación a malloc/free.
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <typeinfo>
+#include "utils.hpp"
+
+// Perfilador de evaluación (--profile). Está compilado siempre pero inactivo
+// por defecto: con profile_enabled en false cada ProfileScope solo cuesta una
+// comparación.
+extern bool profile_enabled;
+
+// Contabilidad de memoria (--alloc-profile): operator new/delete cuentan
+// bloques y bytes y los atribuyen a la función del usuario y al tipo de nodo
+// que se está evaluando.
+extern bool alloc_profile_enabled;
+
+// Con allocation_counting solo se llevan los totales (lo usa --stats);
+// --alloc-profile lo activa también.
+extern bool allocation_counting;
+
+struct AllocationCount {
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+};
+
+AllocationCount allocation_count() noexcept;
+
+// Bytes asignados y todavía no liberados desde que se activó el conteo
+std::uint64_t live_allocated_bytes() noexcept;
+
+// Perfil por línea del programa (--profile-lines): tiempo propio y cantidad
+// de evals de los nodos de cada línea
+extern bool line_profile_enabled;
+
+void profile_enter_node(const std::type_info& type, std::uint32_t line) noexcept;
+void profile_enter_function(const std::string& name) noexcept;
+void profile_leave_node() noexcept;
+void profile_leave_function() noexcept;
+
+// Imprime el perfil plano ordenado por tiempo exclusivo
+void print_profile_report(FILE* out);
+
+// Imprime los mayores asignadores y el pico de bytes vivos
+void print_allocation_report(FILE* out);
+
+// Imprime el perfil por línea en orden de fuente; source_path (puede ser
+// nullptr) se usa para mostrar el texto de cada línea
+void print_line_profile_report(FILE* out, const char* source_path);
+
+void reset_profile() noexcept;
+
+// Marca la duración de un eval (por tipo de nodo) o de una llamada a una
+// función del usuario; el tiempo se acumula al salir del scope. También es el
+// contexto al que se atribuyen las asignaciones de memoria.
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const Expression& node) noexcept
+        : active{profile_enabled || alloc_profile_enabled || line_profile_enabled}, function{false}
+    {
+        if (active) profile_enter_node(typeid(node), node.get_location().line);
+    }
+
+    explicit ProfileScope(const std::string& function_name) noexcept
+        : active{profile_enabled || alloc_profile_enabled || line_profile_enabled}, function{true}
+    {
+        if (active) profile_enter_function(function_name);
+    }
+
+    ~ProfileScope()
+    {
+        if (!active) return;
+        if (function) profile_leave_function();
+        else profile_leave_node();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    bool active;
+    bool function;
+};
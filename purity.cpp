@@ -0,0 +1,217 @@
+#include "purity.hpp"
+
+#include <algorithm>
+
+namespace {
+
+void combine(PuritySummary& result, PuritySummary child) noexcept
+{
+    result.pure = result.pure && child.pure;
+    result.expensive = result.expensive || child.expensive;
+}
+
+bool is_local(const std::vector<std::string>& locals, const std::string& name) noexcept
+{
+    return std::find(locals.begin(), locals.end(), name) != locals.end();
+}
+
+} // namespace
+
+std::string binding_name(const std::shared_ptr<Expression>& name)
+{
+    auto name_expression = std::dynamic_pointer_cast<NameExpression>(name);
+    return name_expression ? name_expression->get_name() : name->to_string();
+}
+
+PurityAnalyzer::PurityAnalyzer(const Environment& globals)
+{
+    for (const auto& [name, value] : globals) {
+        auto closure = std::dynamic_pointer_cast<Closure>(value);
+        if (closure && functions.count(name) == 0) {
+            functions[name] = closure;
+            pure_functions[name] = true;
+        }
+    }
+    // Punto fijo: una función deja de ser pura si su cuerpo llama a una que
+    // no lo es
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& [name, closure] : functions) {
+            if (!pure_functions[name]) continue;
+            std::vector<std::string> locals = closure->get_parameter_names();
+            if (!visit(*closure->get_body_expression(), locals).pure) {
+                pure_functions[name] = false;
+                changed = true;
+            }
+        }
+    }
+}
+
+PurityAnalyzer::~PurityAnalyzer()
+{
+    // empty
+}
+
+void PurityAnalyzer::mark(Expression& program)
+{
+    marking = true;
+    std::vector<std::string> locals;
+    visit(program, locals);
+    for (const auto& [name, closure] : functions) {
+        locals = closure->get_parameter_names();
+        visit(*closure->get_body_expression(), locals);
+    }
+    marking = false;
+}
+
+void PurityAnalyzer::on_binary(BinaryExpression&, PuritySummary, PuritySummary)
+{
+    // empty
+}
+
+void PurityAnalyzer::on_let(LetExpression&, const std::vector<PuritySummary>&)
+{
+    // empty
+}
+
+PuritySummary PurityAnalyzer::visit(Expression& node, std::vector<std::string>& locals)
+{
+    if (dynamic_cast<PrintExpression*>(&node) || dynamic_cast<AssignmentExpression*>(&node) ||
+        dynamic_cast<FunExpression*>(&node)) {
+        return {false, false};
+    }
+    if (auto call = dynamic_cast<CallExpression*>(&node)) {
+        bool pure = true;
+        for (const auto& argument : call->get_arguments()) {
+            pure = visit(*argument, locals).pure && pure;
+        }
+        auto name = std::dynamic_pointer_cast<NameExpression>(call->get_left_expression());
+        if (!name || is_local(locals, name->get_name())) {
+            // Función recibida o definida con letrec: no se sabe cuál es
+            return {false, true};
+        }
+        auto found = pure_functions.find(name->get_name());
+        return {pure && found != pure_functions.end() && found->second, true};
+    }
+    // map, filter y fold llaman a su función una vez por elemento
+    if (dynamic_cast<MapExpression*>(&node) || dynamic_cast<FilterExpression*>(&node)) {
+        auto& pipeline = static_cast<BinaryExpression&>(node);
+        PuritySummary result = visit(*pipeline.get_right_expression(), locals);
+        result.pure = result.pure && is_pure_function(pipeline.get_left_expression(), locals);
+        return {result.pure, true};
+    }
+    if (auto fold = dynamic_cast<FoldExpression*>(&node)) {
+        PuritySummary result = visit(*fold->get_initial_expression(), locals);
+        combine(result, visit(*fold->get_sequence_expression(), locals));
+        result.pure = result.pure && is_pure_function(fold->get_function_name(), locals);
+        return {result.pure, true};
+    }
+    if (auto map = dynamic_cast<MapLiteralExpression*>(&node)) {
+        PuritySummary result{true, false};
+        for (const auto& [key, value] : map->get_entries()) {
+            combine(result, visit(*key, locals));
+            combine(result, visit(*value, locals));
+        }
+        return result;
+    }
+    if (auto put = dynamic_cast<MapPutExpression*>(&node)) {
+        PuritySummary result = visit(*put->get_map_expression(), locals);
+        combine(result, visit(*put->get_key_expression(), locals));
+        combine(result, visit(*put->get_value_expression(), locals));
+        return result;
+    }
+    if (auto slice = dynamic_cast<SliceExpression*>(&node)) {
+        PuritySummary result = visit(*slice->get_array_expression(), locals);
+        combine(result, visit(*slice->get_begin_expression(), locals));
+        combine(result, visit(*slice->get_end_expression(), locals));
+        return result;
+    }
+    if (auto let = dynamic_cast<LetExpression*>(&node)) {
+        return visit_let(*let, locals);
+    }
+    if (auto if_else = dynamic_cast<IfElseExpression*>(&node)) {
+        PuritySummary result{true, false};
+        for (const auto& child : {if_else->get_condition_expression(), if_else->get_true_expression(),
+                                  if_else->get_false_expression()}) {
+            combine(result, visit(*child, locals));
+        }
+        return result;
+    }
+    if (auto array = dynamic_cast<ArrayExpression*>(&node)) {
+        PuritySummary result{true, false};
+        for (const auto& element : array->get_elements()) {
+            combine(result, visit(*element, locals));
+        }
+        return result;
+    }
+    if (auto tuple = dynamic_cast<TupleExpression*>(&node)) {
+        PuritySummary result{true, false};
+        for (const auto& element : tuple->get_elements()) {
+            combine(result, visit(*element, locals));
+        }
+        return result;
+    }
+    if (auto unary = dynamic_cast<UnaryExpression*>(&node)) {
+        return visit(*unary->get_expression(), locals);
+    }
+    if (auto binary = dynamic_cast<BinaryExpression*>(&node)) {
+        PuritySummary left = visit(*binary->get_left_expression(), locals);
+        PuritySummary right = visit(*binary->get_right_expression(), locals);
+        if (marking) {
+            on_binary(*binary, left, right);
+        }
+        return {left.pure && right.pure, left.expensive || right.expensive};
+    }
+    if (dynamic_cast<NameExpression*>(&node) || dynamic_cast<IntExpression*>(&node) ||
+        dynamic_cast<RealExpression*>(&node) || dynamic_cast<StrExpression*>(&node) ||
+        dynamic_cast<BoolExpression*>(&node)) {
+        return {true, false};
+    }
+    return {false, false};
+}
+
+bool PurityAnalyzer::is_pure_function(const std::shared_ptr<Expression>& name_expression,
+                                      const std::vector<std::string>& locals) const
+{
+    auto name = std::dynamic_pointer_cast<NameExpression>(name_expression);
+    if (!name || is_local(locals, name->get_name())) {
+        return false;
+    }
+    auto found = pure_functions.find(name->get_name());
+    return found != pure_functions.end() && found->second;
+}
+
+PuritySummary PurityAnalyzer::visit_let(LetExpression& let, std::vector<std::string>& locals)
+{
+    std::size_t scope_size = locals.size();
+    PuritySummary result{true, false};
+    if (let.is_recursive()) {
+        for (const auto& [name, expression] : let.get_bindings()) {
+            locals.push_back(binding_name(name));
+        }
+        // Los cuerpos de las funciones locales también se recorren
+        for (const auto& [name, expression] : let.get_bindings()) {
+            auto function = std::dynamic_pointer_cast<FunExpression>(expression);
+            if (!function) continue;
+            std::vector<std::string> function_locals = locals;
+            for (const auto& parameter : function->get_parameter_names()) {
+                function_locals.push_back(parameter);
+            }
+            visit(*function->get_body_expression(), function_locals);
+        }
+    } else {
+        std::vector<PuritySummary> bindings;
+        for (const auto& [name, expression] : let.get_bindings()) {
+            bindings.push_back(visit(*expression, locals));
+            combine(result, bindings.back());
+            locals.push_back(binding_name(name));
+        }
+        if (marking) {
+            on_let(let, bindings);
+        }
+    }
+    combine(result, visit(*let.get_body_expression(), locals));
+    locals.resize(scope_size);
+    return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "expression.hpp"
+
+// Análisis de pureza (lo usan --parallel y --lazy-let). Una expresión es pura
+// si su evaluación no tiene efectos visibles: no usa print, asignaciones ni
+// fun anidadas y solo llama funciones globales puras. Entonces se puede
+// evaluar en otro hilo, en otro orden o no evaluarse. Es cara si contiene
+// alguna llamada.
+struct PuritySummary {
+    bool pure;
+    bool expensive;
+};
+
+class PurityAnalyzer
+{
+public:
+    // Calcula qué funciones globales son puras
+    explicit PurityAnalyzer(const Environment& globals);
+
+    virtual ~PurityAnalyzer();
+
+    // Recorre el programa y los cuerpos de las funciones globales llamando a
+    // los ganchos de cada nodo
+    void mark(Expression& program);
+
+protected:
+    // Los ganchos no hacen nada por defecto; en let no recursivos, bindings
+    // tiene el resumen de cada variable
+    virtual void on_binary(BinaryExpression& node, PuritySummary left, PuritySummary right);
+    virtual void on_let(LetExpression& node, const std::vector<PuritySummary>& bindings);
+
+private:
+    PuritySummary visit(Expression& node, std::vector<std::string>& locals);
+    PuritySummary visit_let(LetExpression& let, std::vector<std::string>& locals);
+    // Función global pura, nombrada sin ser parámetro ni letrec
+    bool is_pure_function(const std::shared_ptr<Expression>& name, const std::vector<std::string>& locals) const;
+
+    std::map<std::string, std::shared_ptr<Closure>> functions;
+    std::map<std::string, bool> pure_functions;
+    // En false mientras se calcula pure_functions: los ganchos no se llaman
+    bool marking = false;
+};
+
+// Nombre de la variable de un binding de let
+std::string binding_name(const std::shared_ptr<Expression>& name);
@@ -0,0 +1,122 @@
+#include "sampler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+bool sampling_enabled = false;
+SampleStack sample_stack;
+
+namespace {
+
+// Cada muestra guarda (inicio, profundidad) dentro de un único arreglo de
+// marcos. Todo se reserva al iniciar: el manejador no puede asignar memoria.
+constexpr std::size_t kMaxSamples = 1 << 16;
+constexpr std::size_t kMaxSampleFrames = 1 << 22;
+
+struct Sample {
+    std::uint32_t start;
+    std::uint32_t depth;
+};
+
+std::vector<Sample> samples;
+std::vector<const char*> sample_frames;
+volatile std::sig_atomic_t sample_count = 0;
+std::size_t frames_used = 0;
+std::size_t dropped_samples = 0;
+struct sigaction previous_action;
+
+void on_sigprof(int)
+{
+    int saved_errno = errno;
+    std::size_t depth = std::min<std::size_t>(sample_stack.depth, kSampleStackCapacity);
+    std::atomic_signal_fence(std::memory_order_acquire);
+    std::size_t index = sample_count;
+    if (index < samples.size() && frames_used + depth <= sample_frames.size()) {
+        std::copy(sample_stack.frames, sample_stack.frames + depth, sample_frames.data() + frames_used);
+        samples[index] = {static_cast<std::uint32_t>(frames_used), static_cast<std::uint32_t>(depth)};
+        frames_used += depth;
+        sample_count = index + 1;
+    } else {
+        ++dropped_samples;
+    }
+    errno = saved_errno;
+}
+
+} // namespace
+
+bool start_sampling(long interval_us) noexcept
+{
+    try {
+        samples.assign(kMaxSamples, Sample{0, 0});
+        sample_frames.assign(kMaxSampleFrames, nullptr);
+    } catch (...) {
+        return false;
+    }
+    sample_count = 0;
+    frames_used = 0;
+    dropped_samples = 0;
+    sample_stack.depth = 0;
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof action);
+    action.sa_handler = on_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+        return false;
+    }
+
+    itimerval timer{};
+    timer.it_interval.tv_sec = interval_us / 1000000;
+    timer.it_interval.tv_usec = interval_us % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previous_action, nullptr);
+        return false;
+    }
+    return true;
+}
+
+void stop_sampling() noexcept
+{
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previous_action, nullptr);
+}
+
+bool write_folded_stacks(const char* path)
+{
+    // Las pilas iguales se agregan; la raíz "main" cubre el tiempo fuera de las funciones
+    std::map<std::string, std::size_t> folded;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(sample_count); ++i) {
+        std::string stack = "main";
+        for (std::uint32_t j = 0; j < samples[i].depth; ++j) {
+            stack += ';';
+            stack += sample_frames[samples[i].start + j];
+        }
+        ++folded[stack];
+    }
+
+    FILE* out = fopen(path, "w");
+    if (out == nullptr) {
+        return false;
+    }
+    for (const auto& [stack, count] : folded) {
+        fprintf(out, "%s %zu\n", stack.c_str(), count);
+    }
+    fclose(out);
+
+    fprintf(stderr, "%zu samples written to %s", static_cast<std::size_t>(sample_count), path);
+    if (dropped_samples > 0) {
+        fprintf(stderr, " (%zu dropped)", dropped_samples);
+    }
+    fprintf(stderr, "\n");
+    return true;
+}
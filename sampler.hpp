@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <csignal>
+
+// Perfilador por muestreo (--sample archivo). Un temporizador ITIMER_PROF
+// envía SIGPROF y el manejador copia la pila de llamadas del usuario (los
+// CallExpression activos); al terminar se escriben las pilas en formato
+// "folded" (main;f;g 42), el que usan las herramientas de flame graphs.
+extern bool sampling_enabled;
+
+constexpr int kSampleStackCapacity = 4096;
+
+// Pila de nombres de función visible desde el manejador de la señal. Los
+// nombres apuntan al string del NameExpression del AST, que vive durante
+// toda la evaluación.
+struct SampleStack {
+    const char* frames[kSampleStackCapacity];
+    volatile std::sig_atomic_t depth;
+};
+
+extern SampleStack sample_stack;
+
+bool start_sampling(long interval_us) noexcept;
+void stop_sampling() noexcept;
+
+// Escribe las pilas agregadas; retorna false si no se puede abrir el archivo
+bool write_folded_stacks(const char* path);
+
+class SampleScope
+{
+public:
+    explicit SampleScope(const char* function_name) noexcept
+        : active{sampling_enabled}
+    {
+        if (!active) return;
+        int depth = sample_stack.depth;
+        if (depth < kSampleStackCapacity) {
+            sample_stack.frames[depth] = function_name;
+        }
+        // El marco debe estar escrito antes de que la señal vea la nueva profundidad
+        std::atomic_signal_fence(std::memory_order_release);
+        sample_stack.depth = depth + 1;
+    }
+
+    ~SampleScope()
+    {
+        if (active) sample_stack.depth = sample_stack.depth - 1;
+    }
+
+    SampleScope(const SampleScope&) = delete;
+    SampleScope& operator=(const SampleScope&) = delete;
+
+private:
+    bool active;
+};
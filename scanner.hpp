@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Un token se describe como (offset, longitud) dentro del texto fuente. El
+// scanner lo usa para las columnas y para ver si un ( va pegado al
+// identificador anterior; los literales llegan al parser ya convertidos.
+struct TokenSpan {
+    std::size_t offset;
+    std::size_t length;
+};
+
+// Span del último token reconocido por yylex
+extern TokenSpan token_span;
+
+// Mapea el archivo fuente en memoria y prepara el scanner para leer de él.
+// Retorna false si el archivo no se puede mapear (pipe, archivo vacío, ...);
+// en ese caso se debe usar yyin como siempre.
+bool map_source_file(const char* path) noexcept;
+
+void unmap_source_file() noexcept;
+
+// Prepara el scanner para leer un programa desde memoria (benchmarks, pruebas)
+void scan_source_text(const std::string& text);
+
+void release_source_text() noexcept;
+
+// Devuelve un puntero estable a una copia única del identificador
+const char* intern_identifier(const char* text, std::size_t length);
@@ -0,0 +1,405 @@
+#include "stack_eval.hpp"
+#include "expression.hpp"
+#include "budget.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Value = std::shared_ptr<Expression>;
+
+// Nodo hoja con un valor ya calculado: permite aplicar el eval de una
+// operación sin volver a evaluar sus operandos
+class QuotedValue : public Expression
+{
+public:
+    explicit QuotedValue(Value _value) noexcept : value{std::move(_value)} {}
+
+    Value eval(Environment&) const override
+    {
+        return value;
+    }
+
+    std::string to_string() const noexcept override
+    {
+        return value->to_string();
+    }
+
+    std::pair<bool, Datatype> type_check(Environment& env) const noexcept override
+    {
+        return value->type_check(env);
+    }
+
+private:
+    Value value;
+};
+
+// right es nullptr en las operaciones unarias
+using Apply = Value (*)(const Value& left, const Value& right, Environment& env);
+
+// Los operandos viven en la pila de C++ solo mientras dura el eval de la
+// operación; los shared_ptr sin dueño evitan una asignación por operando.
+// Ningún eval guarda ni retorna sus nodos hijos, solo los valores que estos
+// producen.
+Value borrow(const QuotedValue& operand) noexcept
+{
+    return Value{Value{}, const_cast<QuotedValue*>(&operand)};
+}
+
+template <typename T>
+Value apply_unary(const Value& operand, const Value&, Environment& env)
+{
+    QuotedValue quoted{operand};
+    return T(borrow(quoted)).eval(env);
+}
+
+template <typename T>
+Value apply_binary(const Value& left, const Value& right, Environment& env)
+{
+    QuotedValue quoted_left{left};
+    QuotedValue quoted_right{right};
+    return T(borrow(quoted_left), borrow(quoted_right)).eval(env);
+}
+
+// Por dirección del type_info: hashear type_index compara y hashea el nombre
+const std::unordered_map<const std::type_info*, Apply>& operations()
+{
+    static const std::unordered_map<const std::type_info*, Apply> table{
+        {&typeid(NotExpression), apply_unary<NotExpression>},
+        {&typeid(NegExpression), apply_unary<NegExpression>},
+        {&typeid(HeadExpression), apply_unary<HeadExpression>},
+        {&typeid(TailExpression), apply_unary<TailExpression>},
+        {&typeid(FstExpression), apply_unary<FstExpression>},
+        {&typeid(SndExpression), apply_unary<SndExpression>},
+        {&typeid(RtoSExpression), apply_unary<RtoSExpression>},
+        {&typeid(ItoSExpression), apply_unary<ItoSExpression>},
+        {&typeid(ItoRExpression), apply_unary<ItoRExpression>},
+        {&typeid(RtoIExpression), apply_unary<RtoIExpression>},
+        {&typeid(PrintExpression), apply_unary<PrintExpression>},
+        {&typeid(LengthExpression), apply_unary<LengthExpression>},
+        {&typeid(SortExpression), apply_unary<SortExpression>},
+        {&typeid(UnitExpression), apply_unary<UnitExpression>},
+        {&typeid(IsUniTExpression), apply_unary<IsUniTExpression>},
+        {&typeid(ConcatExpression), apply_binary<ConcatExpression>},
+        {&typeid(AddExpression), apply_binary<AddExpression>},
+        {&typeid(SubExpression), apply_binary<SubExpression>},
+        {&typeid(MulExpression), apply_binary<MulExpression>},
+        {&typeid(DivExpression), apply_binary<DivExpression>},
+        {&typeid(ModExpression), apply_binary<ModExpression>},
+        {&typeid(LessExpression), apply_binary<LessExpression>},
+        {&typeid(LessEqExpression), apply_binary<LessEqExpression>},
+        {&typeid(GreaterExpression), apply_binary<GreaterExpression>},
+        {&typeid(GreaterEqExpression), apply_binary<GreaterEqExpression>},
+        {&typeid(EqualExpression), apply_binary<EqualExpression>},
+        {&typeid(NotEqualExpression), apply_binary<NotEqualExpression>},
+        {&typeid(XorExpression), apply_binary<XorExpression>},
+        {&typeid(AndExpression), apply_binary<AndExpression>},
+        {&typeid(OrExpression), apply_binary<OrExpression>},
+        {&typeid(PairExpression), apply_binary<PairExpression>},
+        {&typeid(ArrayAddExpression), apply_binary<ArrayAddExpression>},
+        {&typeid(ArrayDelExpression), apply_binary<ArrayDelExpression>},
+        {&typeid(IndexExpression), apply_binary<IndexExpression>},
+        {&typeid(BsearchExpression), apply_binary<BsearchExpression>},
+    };
+    return table;
+}
+
+enum class Step : std::uint8_t {
+    Leaf,     // se evalúa con eval
+    If,
+    Let,
+    Call,
+    Array,
+    Unary,
+    Binary,
+    Assign,
+};
+
+struct Frame {
+    const Expression* node;
+    Environment* env;
+    Apply apply;          // solo en Unary y Binary
+    std::uint32_t stage;  // hijos ya enviados a evaluar
+    std::uint32_t base;   // tamaño de la pila de valores al crear el marco
+    Step step;
+    bool owns_env;        // el último de environments es de este marco
+};
+
+class Machine
+{
+public:
+    explicit Machine(Environment& _globals) noexcept : globals{_globals} {}
+
+    Value run(const Expression& program)
+    {
+        push(program, &globals);
+        while (!frames.empty()) {
+            step();
+        }
+        return values.back();
+    }
+
+private:
+    // Las hojas (variables, literales) se evalúan en el momento, sin marco
+    void push(const Expression& node, Environment* env)
+    {
+        Frame frame{&node, env, nullptr, 0, static_cast<std::uint32_t>(values.size()), Step::Leaf, false};
+        classify(frame);
+        if (frame.step == Step::Leaf) {
+            values.push_back(node.eval(*env));
+            return;
+        }
+        frames.push_back(frame);
+    }
+
+    static void classify(Frame& frame)
+    {
+        const Expression& node = *frame.node;
+        const auto& type = typeid(node);
+        if (type == typeid(NameExpression) || type == typeid(IntExpression)) {
+            return;
+        } else if (type == typeid(IfElseExpression)) {
+            frame.step = Step::If;
+        } else if (type == typeid(LetExpression)) {
+            frame.step = Step::Let;
+        } else if (type == typeid(CallExpression)) {
+            frame.step = Step::Call;
+        } else if (type == typeid(ArrayExpression) || type == typeid(TupleExpression)) {
+            frame.step = Step::Array;
+        } else if (type == typeid(AssignmentExpression)) {
+            frame.step = Step::Assign;
+        } else {
+            auto found = operations().find(&type);
+            if (found == operations().end()) return;
+            auto unary = dynamic_cast<const UnaryExpression*>(&node);
+            if (unary && unary->get_expression() == nullptr) return;
+            // length de range/map/filter cuenta sin crear el array
+            if (type == typeid(LengthExpression) && is_sequence_expression(*unary->get_expression())) return;
+            frame.apply = found->second;
+            frame.step = unary ? Step::Unary : Step::Binary;
+        }
+    }
+
+    // El valor del nodo ya está al tope de la pila de valores
+    void finish()
+    {
+        if (frames.back().owns_env) {
+            environments.pop_back();
+        }
+        frames.pop_back();
+    }
+
+    Value pop_value()
+    {
+        Value value = std::move(values.back());
+        values.pop_back();
+        return value;
+    }
+
+    // push puede mover el vector de marcos: frame no se usa después de push
+    void step()
+    {
+        Frame& frame = frames.back();
+        switch (frame.step) {
+            case Step::Leaf:
+                values.push_back(frame.node->eval(*frame.env));
+                finish();
+                break;
+            case Step::If:
+                step_if(frame);
+                break;
+            case Step::Let:
+                step_let(frame);
+                break;
+            case Step::Call:
+                step_call(frame);
+                break;
+            case Step::Array:
+                step_array(frame);
+                break;
+            case Step::Unary:
+                if (frame.stage++ == 0) {
+                    push(*static_cast<const UnaryExpression&>(*frame.node).get_expression(), frame.env);
+                } else {
+                    Value operand = pop_value();
+                    values.push_back(frame.apply(operand, nullptr, *frame.env));
+                    finish();
+                }
+                break;
+            case Step::Binary: {
+                const auto& node = static_cast<const BinaryExpression&>(*frame.node);
+                std::uint32_t stage = frame.stage++;
+                if (stage == 0) {
+                    push(*node.get_left_expression(), frame.env);
+                } else if (stage == 1) {
+                    push(*node.get_right_expression(), frame.env);
+                } else {
+                    Value right = pop_value();
+                    Value left = pop_value();
+                    values.push_back(frame.apply(left, right, *frame.env));
+                    finish();
+                }
+                break;
+            }
+            case Step::Assign: {
+                const auto& node = static_cast<const AssignmentExpression&>(*frame.node);
+                if (frame.stage++ == 0) {
+                    push(*node.get_right_expression(), frame.env);
+                } else {
+                    auto name = std::dynamic_pointer_cast<NameExpression>(node.get_left_expression());
+                    frame.env->add(name->get_name(), values.back());
+                    finish();
+                }
+                break;
+            }
+        }
+    }
+
+    void step_if(Frame& frame)
+    {
+        const auto& node = static_cast<const IfElseExpression&>(*frame.node);
+        if (frame.stage++ == 0) {
+            push(*node.get_condition_expression(), frame.env);
+            return;
+        }
+        auto condition = std::dynamic_pointer_cast<BoolExpression>(pop_value());
+        const Expression& branch = condition && condition->get_value() ? *node.get_true_expression()
+                                                                        : *node.get_false_expression();
+        // La rama está en posición de cola: ocupa el lugar del if
+        frame.node = &branch;
+        frame.apply = nullptr;
+        frame.stage = 0;
+        frame.step = Step::Leaf;
+        classify(frame);
+    }
+
+    void step_let(Frame& frame)
+    {
+        const auto& node = static_cast<const LetExpression&>(*frame.node);
+        const auto& bindings = node.get_bindings();
+        std::uint32_t stage = frame.stage++;
+        if (stage == 0) {
+            // Un solo entorno local para todas las variables
+            environments.push_back(*frame.env);
+            Environment* local_env = &environments.back();
+            if (node.is_recursive() && !add_recursive_bindings(bindings, *frame.env, *local_env)) {
+                environments.pop_back();
+                throw std::runtime_error("letrec requires function definitions");
+            }
+            frame.env = local_env;
+            frame.owns_env = true;
+            if (node.is_recursive()) {
+                frame.stage = bindings.size() + 1;
+                push(*node.get_body_expression(), local_env);
+                return;
+            }
+        } else if (stage <= bindings.size()) {
+            auto name_expr = std::dynamic_pointer_cast<NameExpression>(bindings[stage - 1].first);
+            if (!name_expr) {
+                throw std::runtime_error("Let expression requires a variable name");
+            }
+            frame.env->add(name_expr->get_name(), pop_value());
+        } else {
+            finish();
+            return;
+        }
+        // Cada expresión ve las variables anteriores, como en lets anidados
+        if (stage < bindings.size()) {
+            push(*bindings[stage].second, frame.env);
+        } else {
+            push(*node.get_body_expression(), frame.env);
+        }
+    }
+
+    void step_call(Frame& frame)
+    {
+        const auto& node = static_cast<const CallExpression&>(*frame.node);
+        const auto& arguments = node.get_arguments();
+        if (frame.owns_env) {
+            // El closure se mantuvo vivo mientras se evaluaba su cuerpo
+            Value result = pop_value();
+            values.back() = std::move(result);
+            finish();
+            return;
+        }
+        if (frame.stage == 0) {
+            charge_budget();
+            // El closure queda en la pila de valores, debajo de los argumentos
+            auto function_name = std::dynamic_pointer_cast<NameExpression>(node.get_left_expression());
+            const std::string& name = function_name->get_name();
+            auto expression = frame.env->lookup(name);
+            if (expression == nullptr) {
+                expression = globals.lookup(name);
+                if (expression == nullptr) {
+                    throw std::runtime_error{"function " + name + " does not exist"};
+                }
+            }
+            auto closure = std::dynamic_pointer_cast<Closure>(expression);
+            if (!closure) {
+                throw std::runtime_error{name + " is not a function"};
+            }
+            const auto& param_names = closure->get_parameter_names();
+            if (param_names.size() != arguments.size()) {
+                throw std::runtime_error{"function " + name + " expects " + std::to_string(param_names.size()) + " arguments"};
+            }
+            values.push_back(closure);
+        }
+        if (frame.stage < arguments.size()) {
+            Environment* env = frame.env;
+            push(*arguments[frame.stage++], env);
+            return;
+        }
+
+        auto closure = std::static_pointer_cast<Closure>(values[frame.base]);
+        environments.push_back(closure->get_environment());
+        Environment& call_env = environments.back();
+        closure->add_recursive_group(call_env);
+        const auto& param_names = closure->get_parameter_names();
+        for (std::size_t i = 0; i < param_names.size(); ++i) {
+            call_env.add(param_names[i], std::move(values[frame.base + 1 + i]));
+        }
+        values.resize(frame.base + 1);
+        frame.owns_env = true;
+        push(*closure->get_body_expression(), &call_env);
+    }
+
+    // Arrays y tuplas: los elementos en orden, después el valor
+    void step_array(Frame& frame)
+    {
+        bool tuple = typeid(*frame.node) == typeid(TupleExpression);
+        const auto& elements = tuple ? static_cast<const TupleExpression&>(*frame.node).get_elements()
+                                     : static_cast<const ArrayExpression&>(*frame.node).get_elements();
+        if (frame.stage < elements.size()) {
+            Environment* env = frame.env;
+            push(*elements[frame.stage++], env);
+            return;
+        }
+        std::vector<Value> evaluated(values.begin() + frame.base, values.end());
+        values.resize(frame.base);
+        if (tuple) {
+            values.push_back(std::make_shared<TupleExpression>(std::move(evaluated)));
+        } else {
+            values.push_back(std::make_shared<ArrayExpression>(std::move(evaluated)));
+        }
+        finish();
+    }
+
+    Environment& globals;
+    std::vector<Frame> frames;
+    std::vector<Value> values;
+    // deque: agregar o quitar al final no mueve los entornos de los marcos
+    std::deque<Environment> environments;
+};
+
+} // namespace
+
+std::shared_ptr<Expression> eval_with_stack(const Expression& program, Environment& globals)
+{
+    Machine machine{globals};
+    return machine.run(program);
+}
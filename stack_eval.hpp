@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include "utils.hpp"
+
+// Evaluación con pila explícita (--backend=stack). En lugar de que cada eval
+// llame a eval de sus hijos, un solo ciclo recorre el árbol con una pila de
+// marcos de continuación en memoria dinámica: cada marco guarda el nodo, su
+// entorno y cuántos hijos ya se evaluaron, y los resultados parciales van a
+// una pila de valores. Las llamadas, let, if y las operaciones no agregan
+// marcos de C++, así que la profundidad de la recursión solo está limitada
+// por la memoria. La rama de un if reemplaza al marco del if.
+//
+// Las operaciones se aplican con el eval del mismo tipo de nodo sobre los
+// valores ya calculados, así que los resultados y los mensajes de error son
+// los del intérprete de árbol. Lo que no se sabe recorrer (fun anidadas) se
+// evalúa con eval.
+std::shared_ptr<Expression> eval_with_stack(const Expression& program, Environment& globals);
@@ -0,0 +1,273 @@
+#include "stats.hpp"
+#include "profiler.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <sys/resource.h>
+#include <vector>
+
+bool stats_enabled = false;
+
+namespace {
+
+struct PhaseStats {
+    std::uint64_t entries = 0;
+    std::int64_t wall_ns = 0;
+    std::int64_t cpu_ns = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    long peak_rss_kb = 0;  // pico del proceso al salir de la fase
+    PerfCounts perf;
+};
+
+struct Sample {
+    std::int64_t wall_ns;
+    std::int64_t cpu_ns;
+    AllocationCount allocs;
+    PerfCounts perf;
+};
+
+const char* const phase_names[] = {"scan", "parse", "register", "type_check", "compile", "eval"};
+
+PhaseStats phase_stats[static_cast<int>(Phase::Count)];
+std::vector<Phase> phase_stack;
+Sample last_sample;
+PerfCounters perf_counters;
+
+// Escaneo medido por yylex y todavía cargado a la fase actual
+struct PendingScan {
+    std::int64_t wall_ns = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+PendingScan pending_scan;
+// Profundidad de la fase en la que se escanea; al salir de ella se cuenta
+// una entrada de Scan (0: no hay escaneo abierto)
+std::size_t scan_depth = 0;
+
+std::int64_t wall_clock_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Sample take_sample() noexcept
+{
+    timespec cpu;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return {
+        wall_clock_ns(),
+        static_cast<std::int64_t>(cpu.tv_sec) * 1000000000 + cpu.tv_nsec,
+        allocation_count(),
+        perf_counters.read()
+    };
+}
+
+long peak_rss_kb() noexcept
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+PerfCounts scaled(const PerfCounts& counts, double share) noexcept
+{
+    PerfCounts result = counts;
+    for (int i = 0; i < PerfEventCount; ++i) {
+        result.values[i] = static_cast<std::uint64_t>(static_cast<double>(counts.values[i]) * share);
+    }
+    return result;
+}
+
+// Pasa el escaneo acumulado de delta (lo de la fase actual) a Scan
+void move_pending_scan(PhaseStats& delta, bool leaving) noexcept
+{
+    auto& scan = phase_stats[static_cast<int>(Phase::Scan)];
+    if (pending_scan.wall_ns > 0 || pending_scan.allocations > 0) {
+        std::int64_t wall_ns = std::min(pending_scan.wall_ns, delta.wall_ns);
+        double share = delta.wall_ns > 0 ? static_cast<double>(wall_ns) / static_cast<double>(delta.wall_ns) : 0.0;
+        auto cpu_ns = static_cast<std::int64_t>(static_cast<double>(delta.cpu_ns) * share);
+        PerfCounts perf = scaled(delta.perf, share);
+        std::uint64_t allocations = std::min(pending_scan.allocations, delta.allocations);
+        std::uint64_t bytes = std::min(pending_scan.bytes, delta.allocated_bytes);
+
+        scan.wall_ns += wall_ns;
+        scan.cpu_ns += cpu_ns;
+        scan.allocations += allocations;
+        scan.allocated_bytes += bytes;
+        scan.perf += perf;
+        delta.wall_ns -= wall_ns;
+        delta.cpu_ns -= cpu_ns;
+        delta.allocations -= allocations;
+        delta.allocated_bytes -= bytes;
+        delta.perf = delta.perf - perf;
+        pending_scan = PendingScan{};
+    }
+    if (leaving && scan_depth == phase_stack.size()) {
+        ++scan.entries;
+        scan.peak_rss_kb = std::max(scan.peak_rss_kb, peak_rss_kb());
+        scan_depth = 0;
+    }
+}
+
+// Carga a la fase del tope de la pila lo ocurrido desde el último cambio
+void charge_current_phase(bool leaving) noexcept
+{
+    Sample now = take_sample();
+    if (!phase_stack.empty()) {
+        PhaseStats delta;
+        delta.wall_ns = now.wall_ns - last_sample.wall_ns;
+        delta.cpu_ns = now.cpu_ns - last_sample.cpu_ns;
+        delta.allocations = now.allocs.allocations - last_sample.allocs.allocations;
+        delta.allocated_bytes = now.allocs.bytes - last_sample.allocs.bytes;
+        delta.perf = now.perf - last_sample.perf;
+        move_pending_scan(delta, leaving);
+
+        auto& stats = phase_stats[static_cast<int>(phase_stack.back())];
+        stats.wall_ns += delta.wall_ns;
+        stats.cpu_ns += delta.cpu_ns;
+        stats.allocations += delta.allocations;
+        stats.allocated_bytes += delta.allocated_bytes;
+        stats.perf += delta.perf;
+        if (leaving) {
+            stats.peak_rss_kb = std::max(stats.peak_rss_kb, peak_rss_kb());
+        }
+    }
+    // La lectura del reloj se toma de nuevo para no cargar el costo de medir
+    last_sample = take_sample();
+}
+
+void print_rate(FILE* out, double value)
+{
+    if (value < 0) {
+        fprintf(out, " %10s", "n/a");
+    } else {
+        fprintf(out, " %10.2f", value);
+    }
+}
+
+void print_json_rate(FILE* out, const char* name, double value)
+{
+    if (value < 0) {
+        fprintf(out, ", \"%s\": null", name);
+    } else {
+        fprintf(out, ", \"%s\": %.4f", name, value);
+    }
+}
+
+} // namespace
+
+bool enable_perf_counters() noexcept
+{
+    if (!perf_counters.open()) {
+        fprintf(stderr, "Hardware counters unavailable (%s)\n", perf_counters.error().c_str());
+        return false;
+    }
+    last_sample = take_sample();
+    return true;
+}
+
+ScanMark stats_scan_mark() noexcept
+{
+    AllocationCount allocs = allocation_count();
+    return {wall_clock_ns(), allocs.allocations, allocs.bytes};
+}
+
+void stats_add_scan(const ScanMark& start) noexcept
+{
+    ScanMark end = stats_scan_mark();
+    pending_scan.wall_ns += end.wall_ns - start.wall_ns;
+    pending_scan.allocations += end.allocations - start.allocations;
+    pending_scan.bytes += end.bytes - start.bytes;
+    if (scan_depth == 0) {
+        scan_depth = phase_stack.size();
+    }
+}
+
+void stats_enter_phase(Phase phase) noexcept
+{
+    charge_current_phase(false);
+    ++phase_stats[static_cast<int>(phase)].entries;
+    phase_stack.push_back(phase);
+}
+
+void stats_leave_phase() noexcept
+{
+    if (phase_stack.empty()) return;
+    charge_current_phase(true);
+    phase_stack.pop_back();
+}
+
+void print_stats(FILE* out)
+{
+    fprintf(out, "\n=== Phase statistics ===\n");
+    fprintf(out, "%-12s %10s %12s %12s %14s %14s %14s\n",
+            "phase", "entries", "wall ms", "cpu ms", "allocations", "alloc bytes", "peak rss kb");
+    for (int i = 0; i < static_cast<int>(Phase::Count); ++i) {
+        const auto& stats = phase_stats[i];
+        fprintf(out, "%-12s %10llu %12.3f %12.3f %14llu %14llu %14ld\n",
+                phase_names[i],
+                static_cast<unsigned long long>(stats.entries),
+                stats.wall_ns / 1e6,
+                stats.cpu_ns / 1e6,
+                static_cast<unsigned long long>(stats.allocations),
+                static_cast<unsigned long long>(stats.allocated_bytes),
+                stats.peak_rss_kb);
+    }
+    if (!perf_counters.is_open()) return;
+
+    fprintf(out, "\n%-12s %16s %16s %10s %10s %10s %10s\n",
+            "phase", "cycles", "instructions", "ipc", "l1d mpki", "llc mpki", "br mpki");
+    for (int i = 0; i < static_cast<int>(Phase::Count); ++i) {
+        const auto& perf = phase_stats[i].perf;
+        fprintf(out, "%-12s %16llu %16llu", phase_names[i],
+                static_cast<unsigned long long>(perf.values[PerfCycles]),
+                static_cast<unsigned long long>(perf.values[PerfInstructions]));
+        print_rate(out, perf.ipc());
+        print_rate(out, perf.per_kilo_instruction(PerfL1dMisses));
+        print_rate(out, perf.per_kilo_instruction(PerfLlcMisses));
+        print_rate(out, perf.per_kilo_instruction(PerfBranchMisses));
+        fprintf(out, "\n");
+    }
+}
+
+void print_stats_json(FILE* out)
+{
+    fprintf(out, "{\"phases\": {");
+    for (int i = 0; i < static_cast<int>(Phase::Count); ++i) {
+        const auto& stats = phase_stats[i];
+        fprintf(out, "%s\n  \"%s\": {\"entries\": %llu, \"wall_ns\": %lld, \"cpu_ns\": %lld, "
+                     "\"allocations\": %llu, \"allocated_bytes\": %llu, \"peak_rss_kb\": %ld",
+                i == 0 ? "" : ",",
+                phase_names[i],
+                static_cast<unsigned long long>(stats.entries),
+                static_cast<long long>(stats.wall_ns),
+                static_cast<long long>(stats.cpu_ns),
+                static_cast<unsigned long long>(stats.allocations),
+                static_cast<unsigned long long>(stats.allocated_bytes),
+                stats.peak_rss_kb);
+        if (perf_counters.is_open()) {
+            fprintf(out, ", \"perf\": {");
+            for (int e = 0; e < PerfEventCount; ++e) {
+                auto event = static_cast<PerfEvent>(e);
+                if (stats.perf.present[e]) {
+                    fprintf(out, "%s\"%s\": %llu", e == 0 ? "" : ", ", perf_event_name(event),
+                            static_cast<unsigned long long>(stats.perf.values[e]));
+                } else {
+                    fprintf(out, "%s\"%s\": null", e == 0 ? "" : ", ", perf_event_name(event));
+                }
+            }
+            print_json_rate(out, "ipc", stats.perf.ipc());
+            print_json_rate(out, "l1d_mpki", stats.perf.per_kilo_instruction(PerfL1dMisses));
+            print_json_rate(out, "llc_mpki", stats.perf.per_kilo_instruction(PerfLlcMisses));
+            print_json_rate(out, "branch_mpki", stats.perf.per_kilo_instruction(PerfBranchMisses));
+            fprintf(out, "}");
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n}, \"perf_counters\": %s, \"peak_rss_kb\": %ld}\n",
+            perf_counters.is_open() ? "true" : "false", peak_rss_kb());
+}
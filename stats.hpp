@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// Reporte por fases (--stats, --stats-json archivo): tiempo de pared, tiempo
+// de CPU, asignaciones y pico de RSS de cada fase de main. Los tiempos son
+// exclusivos: el escaneo que hace yyparse al pedir tokens y el registro de
+// funciones de create_statement_sequence no se cuentan dentro de "parse".
+enum class Phase {
+    Scan,
+    Parse,
+    Register,
+    TypeCheck,
+    Compile,
+    Eval,
+    Count
+};
+
+extern bool stats_enabled;
+
+// Agrega contadores de hardware (--perf) a cada fase. Retorna false y deja el
+// motivo en stderr si no están disponibles; el reporte sigue sin ellos.
+bool enable_perf_counters() noexcept;
+
+void stats_enter_phase(Phase phase) noexcept;
+void stats_leave_phase() noexcept;
+
+// yylex no cambia de fase en cada token (serían cuatro muestras completas y
+// un getrusage por token): toma una marca barata (reloj de pared y conteo de
+// asignaciones) antes del token y la suma con stats_add_scan. Lo acumulado se
+// pasa de la fase actual a Scan cuando esa fase se carga; el CPU y los
+// contadores de --perf se reparten en proporción al tiempo de pared.
+struct ScanMark {
+    std::int64_t wall_ns;
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+};
+
+ScanMark stats_scan_mark() noexcept;
+void stats_add_scan(const ScanMark& start) noexcept;
+
+void print_stats(FILE* out);
+void print_stats_json(FILE* out);
+
+class PhaseScope
+{
+public:
+    explicit PhaseScope(Phase phase) noexcept
+        : active{stats_enabled}
+    {
+        if (active) stats_enter_phase(phase);
+    }
+
+    ~PhaseScope()
+    {
+        if (active) stats_leave_phase();
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    bool active;
+};
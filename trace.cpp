@@ -0,0 +1,78 @@
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+#include <vector>
+
+bool trace_enabled = false;
+std::int64_t trace_threshold_ns = 10000;
+
+namespace {
+
+struct TraceEvent {
+    const char* category;
+    std::string name;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+};
+
+std::vector<TraceEvent> trace_events;
+const std::int64_t trace_origin_ns = trace_now_ns();
+
+void write_json_string(FILE* out, const std::string& text)
+{
+    fputc('"', out);
+    for (char c : text) {
+        switch (c) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fprintf(out, "\\u%04x", c);
+                } else {
+                    fputc(c, out);
+                }
+        }
+    }
+    fputc('"', out);
+}
+
+} // namespace
+
+std::int64_t trace_now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void add_trace_event(const char* category, const std::string& name,
+                     std::int64_t start_ns, std::int64_t end_ns)
+{
+    trace_events.push_back({category, name, start_ns - trace_origin_ns, end_ns - start_ns});
+}
+
+bool write_trace(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (out == nullptr) {
+        return false;
+    }
+    // ts y dur van en microsegundos, como espera el visor
+    int pid = static_cast<int>(getpid());
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    bool first = true;
+    for (const auto& event : trace_events) {
+        fprintf(out, "%s\n  {\"name\": ", first ? "" : ",");
+        write_json_string(out, event.name);
+        fprintf(out, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": 1}",
+                event.category, event.start_ns / 1e3, event.duration_ns / 1e3, pid);
+        first = false;
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    fprintf(stderr, "%zu trace events written to %s\n", trace_events.size(), path);
+    return true;
+}
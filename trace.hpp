@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Línea de tiempo en formato Chrome trace-event (--trace salida.json). Se
+// registran eventos completos ("ph": "X") para las fases de main, cada
+// sentencia de primer nivel y las llamadas a funciones del usuario que duran
+// al menos trace_threshold_ns.
+extern bool trace_enabled;
+extern std::int64_t trace_threshold_ns;
+
+std::int64_t trace_now_ns() noexcept;
+
+void add_trace_event(const char* category, const std::string& name,
+                     std::int64_t start_ns, std::int64_t end_ns);
+
+// Escribe los eventos; retorna false si no se puede abrir el archivo
+bool write_trace(const char* path);
+
+class TraceScope
+{
+public:
+    // Con filtered en true el evento solo se guarda si supera el umbral
+    TraceScope(const char* _category, const std::string& _name, bool _filtered = false) noexcept
+        : active{trace_enabled}, filtered{_filtered}, category{_category}, start_ns{0}
+    {
+        if (!active) return;
+        name = _name;
+        start_ns = trace_now_ns();
+    }
+
+    // El nombre es prefix + _name; se arma solo con la traza activa
+    TraceScope(const char* _category, const char* prefix, const std::string& _name, bool _filtered = false) noexcept
+        : active{trace_enabled}, filtered{_filtered}, category{_category}, start_ns{0}
+    {
+        if (!active) return;
+        name = prefix + _name;
+        start_ns = trace_now_ns();
+    }
+
+    ~TraceScope()
+    {
+        if (!active) return;
+        auto end_ns = trace_now_ns();
+        if (!filtered || end_ns - start_ns >= trace_threshold_ns) {
+            add_trace_event(category, name, start_ns, end_ns);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    bool active;
+    bool filtered;
+    const char* category;
+    std::string name;  // solo se copia con la traza activa
+    std::int64_t start_ns;
+};
@@ -1,6 +1,8 @@
 #include <sstream>
 #include <utils.hpp>
 #include "expression.hpp"
+#include "profiler.hpp"
+#include "parallel.hpp"
 
 // Forward declarations para evitar dependencias circulares
 class PairExpression;
@@ -8,11 +10,24 @@ class NameExpression;
 class SndExpression;
 class FstExpression;
 
+SourceLocation current_source_location;
+
+Expression::Expression() noexcept
+    : location{current_source_location}
+{
+    // empty
+}
+
 Expression::~Expression()
 {
     // empty
 }
 
+const SourceLocation& Expression::get_location() const noexcept
+{
+    return location;
+}
+
 UnaryExpression::UnaryExpression(std::shared_ptr<Expression> _expression) noexcept
     : expression{_expression}
 {
@@ -40,6 +55,20 @@ std::shared_ptr<Expression> BinaryExpression::get_right_expression() const noexc
     return right_expression;
 }
 
+void BinaryExpression::set_parallel(bool value) noexcept
+{
+    parallel = value;
+}
+
+std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>> BinaryExpression::eval_operands(Environment& env) const
+{
+    if (parallel && parallel_enabled) {
+        return fork_join(*left_expression, *right_expression, env);
+    }
+    auto left_value = left_expression->eval(env);
+    return {left_value, right_expression->eval(env)};
+}
+
 void Environment::add(const std::string& identifier, std::shared_ptr<Expression> expression) noexcept
 {
     this->push_front(std::make_pair(identifier, expression));
@@ -84,9 +113,9 @@ std::string Environment::to_string() const noexcept
 }
 
 
-Closure::Closure(const Environment& _env, const std::string& _param_name, std::shared_ptr<Expression> _body,
+Closure::Closure(const Environment& _env, const std::vector<std::string>& _param_names, std::shared_ptr<Expression> _body,
                  Datatype _param_type, Datatype _return_type) noexcept
-    : env{_env}, param_name{_param_name}, body{_body}, parameter_type{_param_type}, return_type{_return_type}
+    : env{_env}, param_names{_param_names}, body{_body}, parameter_type{_param_type}, return_type{_return_type}
 {
     // empty
 }
@@ -96,9 +125,9 @@ const Environment& Closure::get_environment() const noexcept
     return env;
 }
 
-std::string Closure::get_parameter_name() const noexcept
+const std::vector<std::string>& Closure::get_parameter_names() const noexcept
 {
-    return param_name;
+    return param_names;
 }
 
 std::shared_ptr<Expression> Closure::get_body_expression() const noexcept
@@ -118,14 +147,22 @@ Datatype Closure::get_return_type() const noexcept
 
 std::shared_ptr<Expression> Closure::eval(Environment&) const
 {
-    return std::make_shared<Closure>(env, param_name, body, parameter_type, return_type);
+    ProfileScope profile{*this};
+    auto copy = std::make_shared<Closure>(env, param_names, body, parameter_type, return_type);
+    copy->recursive_group = recursive_group;
+    copy->group_owner = recursive_group.lock();
+    return copy;
 }
 
 std::string Closure::to_string() const noexcept
 {
+    std::string parameters;
+    for (const auto& name : param_names) {
+        parameters += name + " ";
+    }
     return "(closure" 
         + env.to_string()
-        + " " + param_name + " " + body->to_string() + ")";
+        + " " + parameters + body->to_string() + ")";
 }
 
 std::pair<bool, Datatype> Closure::type_check(Environment&) const noexcept
@@ -134,6 +171,25 @@ std::pair<bool, Datatype> Closure::type_check(Environment&) const noexcept
     return {true, Datatype::FunctionType};
 }
 
+void Closure::set_recursive_group(const std::shared_ptr<const RecursiveGroup>& group) noexcept
+{
+    recursive_group = group;
+}
+
+bool Closure::has_recursive_group() const noexcept
+{
+    return !recursive_group.expired();
+}
+
+void Closure::add_recursive_group(Environment& call_env) const noexcept
+{
+    auto group = recursive_group.lock();
+    if (!group) return;
+    for (const auto& [name, member] : *group) {
+        call_env.add(name, std::shared_ptr<Closure>(group, member.get()));
+    }
+}
+
 // Implementaciones de PairTypePath y funciones relacionadas
 
 PairTypePath::PairTypePath(std::shared_ptr<Expression> expr, Environment& env) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <forward_list>
 #include <memory>
 #include <string>
@@ -18,9 +19,22 @@ enum class Datatype;
 class PairExpression;
 class Expression;
 
+// Posición en el archivo fuente. Línea 0: nodo creado fuera del parser
+// (por ejemplo, los valores que produce eval).
+struct SourceLocation {
+    std::uint32_t line = 0;
+    std::uint32_t column = 0;
+};
+
+// El parser la fija antes de cada acción (YYLLOC_DEFAULT) y cada nodo la
+// copia al construirse; se limpia al terminar el análisis.
+extern SourceLocation current_source_location;
+
 class Expression
 {
 public:
+    Expression() noexcept;
+
     virtual ~Expression();
 
     virtual std::shared_ptr<Expression> eval(Environment&) const = 0;
@@ -28,6 +42,11 @@ public:
     virtual std::string to_string() const noexcept = 0;
     
     virtual std::pair<bool, Datatype> type_check(Environment&) const noexcept = 0;
+
+    const SourceLocation& get_location() const noexcept;
+
+private:
+    SourceLocation location;
 };
 
 class UnaryExpression : public Expression
@@ -50,9 +69,18 @@ public:
 
     std::shared_ptr<Expression> get_right_expression() const noexcept;
 
+    // Lo fija analyze_parallelism (parallel.hpp) cuando los dos operandos
+    // son puros y caros
+    void set_parallel(bool value) noexcept;
+
+    // Evalúa los dos operandos, en paralelo si el nodo está marcado y
+    // --parallel está activo; si no, primero el izquierdo
+    std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>> eval_operands(Environment& env) const;
+
 private:
     std::shared_ptr<Expression> left_expression;
     std::shared_ptr<Expression> right_expression;
+    bool parallel = false;
 };
 
 using VarList = std::forward_list<std::pair<std::string, std::shared_ptr<Expression>>>;
@@ -74,12 +102,12 @@ public:
 class Closure : public Expression
 {
 public:
-    Closure(const Environment& _env, const std::string& _param_name, std::shared_ptr<Expression> _body,
+    Closure(const Environment& _env, const std::vector<std::string>& _param_names, std::shared_ptr<Expression> _body,
             Datatype _param_type, Datatype _return_type) noexcept;
 
     const Environment& get_environment() const noexcept;
 
-    std::string get_parameter_name() const noexcept;
+    const std::vector<std::string>& get_parameter_names() const noexcept;
     std::shared_ptr<Expression> get_body_expression() const noexcept;
     
     Datatype get_parameter_type() const noexcept;
@@ -91,12 +119,25 @@ public:
     
     std::pair<bool, Datatype> type_check(Environment&) const noexcept override;
 
+    // letrec: las funciones del grupo (incluida esta) se agregan al entorno de
+    // cada llamada. El grupo es dueño de sus closures y cada uno lo ve con un
+    // weak_ptr; los valores del entorno apuntan al closure con aliasing sobre
+    // el grupo, así una función que sale del letrec retiene a sus hermanas
+    // sin formar un ciclo.
+    using RecursiveGroup = std::vector<std::pair<std::string, std::shared_ptr<Closure>>>;
+
+    void set_recursive_group(const std::shared_ptr<const RecursiveGroup>& group) noexcept;
+    bool has_recursive_group() const noexcept;
+    void add_recursive_group(Environment& call_env) const noexcept;
+
 private:
     Environment env;
-    std::string param_name;
+    std::vector<std::string> param_names;
     std::shared_ptr<Expression> body;
     Datatype parameter_type;
     Datatype return_type;
+    std::weak_ptr<const RecursiveGroup> recursive_group;
+    std::shared_ptr<const RecursiveGroup> group_owner;  // solo en las copias de eval
 };
 
 // Estructura para almacenar información de tipos de pares
@@ -0,0 +1,191 @@
+#include "value_equality.hpp"
+#include "expression.hpp"
+#include "persistent_map.hpp"
+
+#include <cstring>
+#include <typeinfo>
+
+namespace {
+
+std::uint64_t mix(std::uint64_t x) noexcept
+{
+    // Finalizador de splitmix64
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t combine(std::uint64_t seed, std::uint64_t hash) noexcept
+{
+    return mix(seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// Marcas para que un array, un par y un map con el mismo contenido no
+// tengan el mismo hash
+constexpr std::uint64_t kArrayTag = 0x61c8864680b583ebULL;
+constexpr std::uint64_t kPairTag = 0x3c6ef372fe94f82bULL;
+constexpr std::uint64_t kTupleTag = 0xbb67ae8584caa73bULL;
+constexpr std::uint64_t kMapTag = 0xa54ff53a5f1d36f1ULL;
+
+template <typename Node>
+const Node& as(const Expression& value) noexcept
+{
+    return static_cast<const Node&>(value);
+}
+
+// Los arrays que salen de otro (append, slice, sort) comparten elementos.
+// Un elemento compartido solo es igual a sí mismo sin comparar si no puede
+// tener un real: NaN no es igual a sí mismo, así que los reales y los
+// contenedores se comparan siempre.
+bool same_scalar(const std::shared_ptr<Expression>& left, const std::shared_ptr<Expression>& right) noexcept
+{
+    if (left != right) return false;
+    const std::type_info& type = typeid(*left);
+    return type == typeid(IntExpression) || type == typeid(BoolExpression) || type == typeid(StrExpression);
+}
+
+bool equal_elements(const std::vector<std::shared_ptr<Expression>>& left,
+                    const std::vector<std::shared_ptr<Expression>>& right) noexcept
+{
+    if (left.size() != right.size()) return false;
+    for (std::size_t i = 0; i < left.size(); ++i) {
+        if (!same_scalar(left[i], right[i]) && !equal_values(*left[i], *right[i])) return false;
+    }
+    return true;
+}
+
+bool equal_maps(const PersistentMap& left, const PersistentMap& right) noexcept
+{
+    if (left.size() != right.size()) return false;
+    bool equal = true;
+    left.for_each([&](const PersistentMap::Value& key, const PersistentMap::Value& value) {
+        if (!equal) return;
+        const PersistentMap::Value* other = right.find(*key);
+        equal = other && (same_scalar(*other, value) || equal_values(**other, *value));
+    });
+    return equal;
+}
+
+} // namespace
+
+bool equal_values(const Expression& left, const Expression& right) noexcept
+{
+    // Sin atajo por identidad: x == x es false si x es NaN
+    // Un solo typeid por lado en vez de una cadena de dynamic_cast
+    const std::type_info& type = typeid(left);
+    if (type != typeid(right)) return false;
+
+    if (type == typeid(IntExpression)) {
+        return as<IntExpression>(left).get_value() == as<IntExpression>(right).get_value();
+    }
+    if (type == typeid(RealExpression)) {
+        return as<RealExpression>(left).get_value() == as<RealExpression>(right).get_value();
+    }
+    if (type == typeid(BoolExpression)) {
+        return as<BoolExpression>(left).get_value() == as<BoolExpression>(right).get_value();
+    }
+    if (type == typeid(StrExpression)) {
+        return as<StrExpression>(left).get_value() == as<StrExpression>(right).get_value();
+    }
+    if (type == typeid(ArrayExpression)) {
+        return equal_elements(as<ArrayExpression>(left).get_elements(), as<ArrayExpression>(right).get_elements());
+    }
+    if (type == typeid(TupleExpression)) {
+        return equal_elements(as<TupleExpression>(left).get_elements(), as<TupleExpression>(right).get_elements());
+    }
+    if (type == typeid(PairExpression)) {
+        const auto& l = as<PairExpression>(left);
+        const auto& r = as<PairExpression>(right);
+        return (same_scalar(l.get_left_expression(), r.get_left_expression()) ||
+                equal_values(*l.get_left_expression(), *r.get_left_expression())) &&
+               (same_scalar(l.get_right_expression(), r.get_right_expression()) ||
+                equal_values(*l.get_right_expression(), *r.get_right_expression()));
+    }
+    if (type == typeid(MapValue)) {
+        return equal_maps(as<MapValue>(left).get_map(), as<MapValue>(right).get_map());
+    }
+    // Funciones: solo por identidad
+    return &left == &right;
+}
+
+bool is_hashable(const Expression& value) noexcept
+{
+    const std::type_info& type = typeid(value);
+    if (type == typeid(IntExpression) || type == typeid(RealExpression) || type == typeid(StrExpression) ||
+        type == typeid(BoolExpression)) {
+        return true;
+    }
+    if (type == typeid(ArrayExpression) || type == typeid(TupleExpression)) {
+        const auto& elements = type == typeid(ArrayExpression) ? as<ArrayExpression>(value).get_elements()
+                                                                : as<TupleExpression>(value).get_elements();
+        for (const auto& element : elements) {
+            if (!is_hashable(*element)) return false;
+        }
+        return true;
+    }
+    if (type == typeid(PairExpression)) {
+        const auto& pair = as<PairExpression>(value);
+        return is_hashable(*pair.get_left_expression()) && is_hashable(*pair.get_right_expression());
+    }
+    if (type == typeid(MapValue)) {
+        bool hashable = true;
+        as<MapValue>(value).get_map().for_each([&](const PersistentMap::Value&, const PersistentMap::Value& item) {
+            hashable = hashable && is_hashable(*item);
+        });
+        return hashable;
+    }
+    return false;
+}
+
+std::uint64_t hash_value(const Expression& value) noexcept
+{
+    const std::type_info& type = typeid(value);
+    if (type == typeid(IntExpression)) {
+        return mix(static_cast<std::uint64_t>(static_cast<std::int64_t>(as<IntExpression>(value).get_value())));
+    }
+    if (type == typeid(RealExpression)) {
+        double real = as<RealExpression>(value).get_value();
+        if (real == 0.0) real = 0.0;  // -0.0 == 0.0
+        std::uint64_t bits;
+        std::memcpy(&bits, &real, sizeof bits);
+        return mix(bits ^ 0x9e3779b97f4a7c15ULL);
+    }
+    if (type == typeid(StrExpression)) {
+        // FNV-1a
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (unsigned char c : as<StrExpression>(value).get_value()) {
+            hash = (hash ^ c) * 0x100000001b3ULL;
+        }
+        return mix(hash);
+    }
+    if (type == typeid(BoolExpression)) {
+        return mix(as<BoolExpression>(value).get_value() ? 0x2545f4914f6cdd1dULL : 0x5851f42d4c957f2dULL);
+    }
+    if (type == typeid(ArrayExpression) || type == typeid(TupleExpression)) {
+        bool array = type == typeid(ArrayExpression);
+        const auto& elements = array ? as<ArrayExpression>(value).get_elements()
+                                     : as<TupleExpression>(value).get_elements();
+        std::uint64_t hash = mix((array ? kArrayTag : kTupleTag) ^ elements.size());
+        for (const auto& element : elements) {
+            hash = combine(hash, hash_value(*element));
+        }
+        return hash;
+    }
+    if (type == typeid(PairExpression)) {
+        const auto& pair = as<PairExpression>(value);
+        return combine(combine(kPairTag, hash_value(*pair.get_left_expression())),
+                       hash_value(*pair.get_right_expression()));
+    }
+    if (type == typeid(MapValue)) {
+        // Suma: no depende del orden en que el trie guarda las entradas
+        const auto& map = as<MapValue>(value).get_map();
+        std::uint64_t sum = 0;
+        map.for_each([&](const PersistentMap::Value& key, const PersistentMap::Value& item) {
+            sum += combine(hash_value(*key), hash_value(*item));
+        });
+        return combine(kMapTag ^ map.size(), sum);
+    }
+    return 0;
+}
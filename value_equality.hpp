@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include "utils.hpp"
+
+// Igualdad estructural y hash de valores ya evaluados. Los int, real,
+// string y bool se comparan por valor; los arrays, pares, tuplas y maps
+// elemento a elemento. Un int y un real con el mismo valor son distintos, y un valor
+// con funciones adentro no es igual a nada salvo a sí mismo. Los elementos
+// compartidos int, string y bool no se comparan; los reales sí, porque NaN
+// no es igual a sí mismo.
+bool equal_values(const Expression& left, const Expression& right) noexcept;
+
+// Los valores que pueden ser llaves de un map: escalares y arrays, pares,
+// tuplas y maps formados solo por ellos
+bool is_hashable(const Expression& value) noexcept;
+
+// Valores iguales según equal_values tienen el mismo hash
+std::uint64_t hash_value(const Expression& value) noexcept;